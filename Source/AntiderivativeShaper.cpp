@@ -0,0 +1,171 @@
+/*
+  ==============================================================================
+
+	Antiderivative anti-aliasing (ADAA) versions of the waveshaper curves.
+
+  ==============================================================================
+*/
+
+#include "AntiderivativeShaper.h"
+
+AntiderivativeTable::AntiderivativeTable(WaveshaperCurve curve)
+{
+	nodes.resize((size_t)numSegments + 1);
+
+	auto xAt = [](size_t index) { return -range + step * (double)index; };
+
+	for (size_t i = 0; i < nodes.size(); ++i)
+		nodes[i].f = WaveshaperReference::evaluate(curve, xAt(i));
+
+	// Composite Simpson over each segment for F1, then the exact integral of the
+	// Hermite cubic of F1 for F2. Integrate outwards from x = 0 in both directions.
+	constexpr int subdivisions = 8;
+
+	auto integrateF = [curve](double from, double to)
+	{
+		const auto h = (to - from) / subdivisions;
+		auto sum = WaveshaperReference::evaluate(curve, from) + WaveshaperReference::evaluate(curve, to);
+
+		for (int k = 1; k < subdivisions; ++k)
+			sum += (k % 2 == 1 ? 4.0 : 2.0) * WaveshaperReference::evaluate(curve, from + h * k);
+
+		return sum * h / 3.0;
+	};
+
+	auto integrateF1 = [](const Node& from, const Node& to, double h)
+	{
+		return h * (from.F1 + to.F1) * 0.5 + h * h * (from.f - to.f) / 12.0;
+	};
+
+	const auto centre = (size_t)numSegments / 2;
+	nodes[centre].F1 = nodes[centre].F2 = 0.0;
+
+	for (auto i = centre; i < (size_t)numSegments; ++i)
+	{
+		nodes[i + 1].F1 = nodes[i].F1 + integrateF(xAt(i), xAt(i + 1));
+		nodes[i + 1].F2 = nodes[i].F2 + integrateF1(nodes[i], nodes[i + 1], step);
+	}
+
+	for (auto i = centre; i > 0; --i)
+	{
+		nodes[i - 1].F1 = nodes[i].F1 - integrateF(xAt(i - 1), xAt(i));
+		nodes[i - 1].F2 = nodes[i].F2 - integrateF1(nodes[i - 1], nodes[i], step);
+	}
+}
+
+void AntiderivativeTable::locate(double x, size_t& index, double& t) const noexcept
+{
+	const auto position = (juce::jlimit(-range, range, x) + range) / step;
+	index = (size_t)juce::jmin((int)position, numSegments - 1);
+	t = position - (double)index;
+}
+
+double AntiderivativeTable::hermite(double p0, double m0, double p1, double m1, double t) noexcept
+{
+	const auto t2 = t * t;
+	const auto t3 = t2 * t;
+
+	return (2.0 * t3 - 3.0 * t2 + 1.0) * p0
+		+ (t3 - 2.0 * t2 + t) * step * m0
+		+ (-2.0 * t3 + 3.0 * t2) * p1
+		+ (t3 - t2) * step * m1;
+}
+
+double AntiderivativeTable::f(double x) const noexcept
+{
+	size_t i;
+	double t;
+	locate(x, i, t);
+	return nodes[i].f + (nodes[i + 1].f - nodes[i].f) * t;
+}
+
+double AntiderivativeTable::F1(double x) const noexcept
+{
+	size_t i;
+	double t;
+	locate(x, i, t);
+	return hermite(nodes[i].F1, nodes[i].f, nodes[i + 1].F1, nodes[i + 1].f, t);
+}
+
+double AntiderivativeTable::F2(double x) const noexcept
+{
+	size_t i;
+	double t;
+	locate(x, i, t);
+	return hermite(nodes[i].F2, nodes[i].F1, nodes[i + 1].F2, nodes[i + 1].F1, t);
+}
+
+const AntiderivativeTable& AntiderivativeTable::get(WaveshaperCurve curve)
+{
+	static const std::array<AntiderivativeTable, 6> tables{
+		AntiderivativeTable(WaveshaperCurve::SoftClip),
+		AntiderivativeTable(WaveshaperCurve::HardClip),
+		AntiderivativeTable(WaveshaperCurve::Tanh),
+		AntiderivativeTable(WaveshaperCurve::Arctan),
+		AntiderivativeTable(WaveshaperCurve::AsymmetricTube),
+		AntiderivativeTable(WaveshaperCurve::Foldback)
+	};
+
+	return tables[(size_t)curve];
+}
+
+juce::String createAntiderivativeRangeReport(bool& passed)
+{
+	using Shaper = Waveshaper<float>;
+	using Register = Shaper::Register;
+
+	// Steps of 1/256 are exact in float up to the range; 2e-3 covers a foldback corner falling inside a step.
+	constexpr double from = 64.0, step = 1.0 / 256.0, tolerance = 2.0e-3;
+	const auto numSteps = (int)((WaveshaperReference::inputRange - from) / step);
+
+	juce::String report;
+	report << "curve              1st order error  2nd order error  (ADAA against direct, |x| from "
+		<< from << " to " << WaveshaperReference::inputRange << ")\n";
+	passed = true;
+
+	for (int c = 0; c < getWaveshaperCurveNames().size(); ++c)
+	{
+		const auto curve = (WaveshaperCurve)c;
+		Shaper shaper;
+		shaper.setCurve(curve);
+		report << getWaveshaperCurveNames()[c].paddedRight(' ', 19);
+
+		for (auto mode : { AntialiasingMode::FirstOrder, AntialiasingMode::SecondOrder })
+		{
+			double maxError = 0.0;
+
+			for (auto sign : { 1.0, -1.0 })
+			{
+				AntiderivativeShaper<float> adaa;
+				adaa.setCurve(curve);
+				adaa.setMode(mode);
+
+				// Both orders' history starts on the ramp, not at zero.
+				auto previous = (float)(sign * from);
+				adaa.processSample(Register::expand(previous));
+				adaa.processSample(Register::expand(previous));
+
+				for (int i = 1; i <= numSteps; ++i)
+				{
+					const auto x = (float)(sign * (from + step * i));
+					const auto y = adaa.processSample(Register::expand(x)).get(0);
+
+					// On a ramp, 1st order gives the curve half a step back and 2nd order a whole step back.
+					const auto at = mode == AntialiasingMode::FirstOrder ? 0.5f * (x + previous) : previous;
+					float direct = 0.f;
+					shaper.process([&](const auto& fn) { direct = fn(Register::expand(at)).get(0); });
+
+					maxError = juce::jmax(maxError, std::abs((double)y - (double)direct));
+					previous = x;
+				}
+			}
+
+			passed = passed && maxError <= tolerance;
+			report << (juce::String(maxError, 8) + (maxError <= tolerance ? "" : " FAIL")).paddedRight(' ', 17);
+		}
+
+		report << "\n";
+	}
+
+	return report;
+}
@@ -0,0 +1,185 @@
+/*
+  ==============================================================================
+
+	Antiderivative anti-aliasing (ADAA) versions of the waveshaper curves.
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+#include "Waveshaper.h"
+
+enum class AntialiasingMode
+{
+	Off,
+	FirstOrder,
+	SecondOrder
+};
+
+//==============================================================================
+/**
+	First and second antiderivatives of one WaveshaperCurve, tabulated in double
+	precision and read back with cubic Hermite interpolation (each level uses the
+	level below as its slope, so F1' = f and F2' = F1 hold between the nodes too).
+
+	Both are pinned to zero at x = 0 to keep their magnitudes, and so the
+	cancellation in the divided differences, small. The tables cover the same
+	input range as the direct curves, so foldback keeps folding with ADAA on.
+*/
+class AntiderivativeTable
+{
+public:
+	static constexpr double range = WaveshaperReference::inputRange;
+	static constexpr int numSegments = 30720;
+	static constexpr double step = 2.0 * range / numSegments;
+
+	explicit AntiderivativeTable(WaveshaperCurve curve);
+
+	double f(double x) const noexcept;
+	double F1(double x) const noexcept;
+	double F2(double x) const noexcept;
+
+	/** Tables for every curve, built on first use; call from prepareToPlay first. */
+	static const AntiderivativeTable& get(WaveshaperCurve curve);
+
+private:
+	struct Node
+	{
+		double f, F1, F2;
+	};
+
+	void locate(double x, size_t& index, double& t) const noexcept;
+	static double hermite(double p0, double m0, double p1, double m1, double t) noexcept;
+
+	std::vector<Node> nodes;
+};
+
+//==============================================================================
+/**
+	Runs a waveshaper curve through 1st- or 2nd-order ADAA at the current rate,
+	as a cheaper way than oversampling to push aliasing down.
+
+	The divided differences have no SIMD division to lean on and need double
+	precision anyway, so each lane is evaluated on its own. When consecutive
+	inputs are too close for the difference to be trustworthy the formulas fall
+	back to evaluating the curve (or F1) at the midpoint, which is the limit the
+	difference tends to.
+
+	ADAA delays the shaped signal by half a sample (1st order) or one sample
+	(2nd order). alignDry() gives the dry signal the same delay so a partial mix
+	does not comb; nothing is added to the reported latency.
+*/
+template <typename FloatType>
+class AntiderivativeShaper
+{
+public:
+	using Register = juce::dsp::SIMDRegister<FloatType>;
+
+	void setMode(AntialiasingMode newMode) noexcept
+	{
+		if (newMode != mode)
+		{
+			mode = newMode;
+			reset();
+		}
+	}
+
+	AntialiasingMode getMode() const noexcept { return mode; }
+
+	void setCurve(WaveshaperCurve curve) noexcept { table = &AntiderivativeTable::get(curve); }
+
+	void reset() noexcept
+	{
+		lanes = {};
+		dryHistory = Register();
+	}
+
+	Register processSample(Register x) noexcept
+	{
+		jassert(table != nullptr);
+		Register y;
+
+		for (size_t lane = 0; lane < Register::size(); ++lane)
+		{
+			const auto in = juce::jlimit(-AntiderivativeTable::range, AntiderivativeTable::range, (double)x.get(lane));
+			y.set(lane, (FloatType)(mode == AntialiasingMode::SecondOrder ? processSecondOrder(lanes[lane], in)
+				: processFirstOrder(lanes[lane], in)));
+		}
+
+		return y;
+	}
+
+	Register alignDry(Register dry) noexcept
+	{
+		const auto previous = dryHistory;
+		dryHistory = dry;
+
+		return mode == AntialiasingMode::SecondOrder ? previous : (dry + previous) * (FloatType)0.5;
+	}
+
+private:
+	struct LaneState
+	{
+		double x1 = 0.0, x2 = 0.0;
+	};
+
+	static constexpr double firstOrderTolerance = 1.0e-5;
+	static constexpr double secondOrderTolerance = 1.0e-4;
+
+	double processFirstOrder(LaneState& state, double x) const noexcept
+	{
+		const auto delta = x - state.x1;
+		const auto y = std::abs(delta) < firstOrderTolerance ? table->f(0.5 * (x + state.x1))
+			: (table->F1(x) - table->F1(state.x1)) / delta;
+
+		state.x1 = x;
+		return y;
+	}
+
+	/** First divided difference of F2, falling back to F1 at the midpoint. */
+	double differenceOfF2(double a, double b) const noexcept
+	{
+		const auto delta = a - b;
+		return std::abs(delta) < secondOrderTolerance ? table->F1(0.5 * (a + b))
+			: (table->F2(a) - table->F2(b)) / delta;
+	}
+
+	double processSecondOrder(LaneState& state, double x) const noexcept
+	{
+		const auto x1 = state.x1, x2 = state.x2;
+		const auto delta = x - x2;
+		double y;
+
+		if (std::abs(delta) >= secondOrderTolerance)
+		{
+			y = 2.0 / delta * (differenceOfF2(x, x1) - differenceOfF2(x1, x2));
+		}
+		else
+		{
+			const auto mean = 0.5 * (x + x2);
+			const auto spread = mean - x1;
+
+			y = std::abs(spread) < secondOrderTolerance ? table->f(0.5 * (mean + x1))
+				: 2.0 / spread * (table->F1(mean) + (table->F2(x1) - table->F2(mean)) / spread);
+		}
+
+		state.x2 = x1;
+		state.x1 = x;
+		return y;
+	}
+
+	AntialiasingMode mode = AntialiasingMode::Off;
+	const AntiderivativeTable* table = nullptr;
+	std::array<LaneState, Register::size()> lanes{};
+	Register dryHistory{};
+};
+
+/**
+	Runs slow ramps through every curve at both ADAA orders for |x| from 64 to
+	WaveshaperReference::inputRange, and compares the output with the direct
+	curve at the point the ramp's ADAA output stands for. Sets passed to false
+	if any curve is off by more than the ramp's own smoothing accounts for.
+*/
+juce::String createAntiderivativeRangeReport(bool& passed);
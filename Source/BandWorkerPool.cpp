@@ -0,0 +1,196 @@
+/*
+  ==============================================================================
+
+	Small pool of real-time worker threads for processing bands in parallel.
+
+  ==============================================================================
+*/
+
+#include "BandWorkerPool.h"
+#include "RealtimeSafety.h"
+
+namespace
+{
+	thread_local int currentWorkerIndex = 0;
+}
+
+class BandWorkerPool::Worker : public juce::Thread
+{
+public:
+	Worker(BandWorkerPool& owner, int index)
+		: juce::Thread("Band worker " + juce::String(index + 1)), pool(owner), workerIndex(index + 1)
+	{
+	}
+
+	void run() override
+	{
+		currentWorkerIndex = workerIndex;
+
+		auto seen = pool.getGeneration();
+		int idleRounds = 0;
+
+		while (!threadShouldExit())
+		{
+			const auto generation = pool.getGeneration();
+
+			if (generation != seen)
+			{
+				seen = generation;
+
+				const RealtimeSafety::ScopedAudioThread audioThread;
+				while (pool.runNextTask(generation)) {}
+				idleRounds = 0;
+				continue;
+			}
+
+			// Stay hot between consecutive blocks, then back off so an idle
+			// plugin does not hold on to a core.
+			if (idleRounds < spinRounds)
+			{
+				++idleRounds;
+			}
+			else if (idleRounds < spinRounds + yieldRounds)
+			{
+				++idleRounds;
+				juce::Thread::yield();
+			}
+			else
+			{
+				// Parked, the worker polls the generation on its own timed wait, so dispatch()
+				// never has to signal it; the first job after a pause is mostly run by the caller.
+				wait(parkedPollMilliseconds);
+			}
+		}
+	}
+
+private:
+	static constexpr int spinRounds = 20000;
+	static constexpr int yieldRounds = 50000;
+	static constexpr int parkedPollMilliseconds = 1;
+
+	BandWorkerPool& pool;
+	const int workerIndex;
+};
+
+BandWorkerPool::BandWorkerPool() = default;
+
+BandWorkerPool::~BandWorkerPool()
+{
+	stop();
+}
+
+void BandWorkerPool::prepare(int numWorkers, int expectedBlockSize, double sampleRate)
+{
+	const auto wasEnabled = !workers.isEmpty();
+	stop();
+
+	numWorkersWanted = juce::jmax(0, numWorkers);
+	blockSize = expectedBlockSize;
+	workerSampleRate = sampleRate;
+
+	setEnabled(wasEnabled);
+}
+
+void BandWorkerPool::setEnabled(bool shouldBeEnabled)
+{
+	if (shouldBeEnabled == !workers.isEmpty() || (shouldBeEnabled && numWorkersWanted == 0))
+		return;
+
+	if (shouldBeEnabled)
+	{
+		const auto options = juce::Thread::RealtimeOptions{}.withApproximateAudioProcessingTime(blockSize, workerSampleRate);
+
+		for (int i = 0; i < numWorkersWanted; ++i)
+		{
+			auto* worker = workers.add(new Worker(*this, i));
+			worker->startRealtimeThread(options);
+		}
+
+		numRunning.store(workers.size(), std::memory_order_relaxed);
+		available.store(true);
+		return;
+	}
+
+	available.store(false);
+	numRunning.store(0, std::memory_order_relaxed);
+
+	// A job already past the check finishes with the workers it found.
+	while (dispatching.load())
+		juce::Thread::yield();
+
+	for (auto* worker : workers)
+		worker->signalThreadShouldExit();
+
+	for (auto* worker : workers)
+	{
+		worker->notify();
+		worker->stopThread(1000);
+	}
+
+	workers.clear();
+}
+
+int BandWorkerPool::getCurrentWorkerIndex() noexcept
+{
+	return currentWorkerIndex;
+}
+
+juce::uint32 BandWorkerPool::getGeneration() const noexcept
+{
+	return (juce::uint32)(cursor.load(std::memory_order_acquire) >> 32);
+}
+
+void BandWorkerPool::dispatch(int numTasks, TaskFunction function, void* context) noexcept
+{
+	jassert(juce::isPositiveAndNotGreaterThan(numTasks, maxTasks));
+
+	dispatching.store(true);
+
+	if (!available.load())
+	{
+		dispatching.store(false, std::memory_order_release);
+
+		for (int index = 0; index < numTasks; ++index)
+			function(context, index);
+
+		return;
+	}
+
+	// Every claim of the previous job has finished by now, so nothing still reads these.
+	taskFunction.store(function, std::memory_order_relaxed);
+	taskContext.store(context, std::memory_order_relaxed);
+	completed.store(0, std::memory_order_relaxed);
+
+	const auto generation = getGeneration() + 1;
+	cursor.store(((juce::uint64)generation << 32) | ((juce::uint64)numTasks << 16), std::memory_order_release);
+
+	while (runNextTask(generation)) {}
+
+	while (completed.load(std::memory_order_acquire) < numTasks) {}
+
+	dispatching.store(false, std::memory_order_release);
+}
+
+bool BandWorkerPool::runNextTask(juce::uint32 generation) noexcept
+{
+	auto current = cursor.load(std::memory_order_acquire);
+
+	for (;;)
+	{
+		if ((juce::uint32)(current >> 32) != generation)
+			return false;
+
+		const auto index = (int)(current & maxTasks);
+		const auto numTasks = (int)((current >> 16) & maxTasks);
+
+		if (index >= numTasks)
+			return false;
+
+		if (cursor.compare_exchange_weak(current, current + 1, std::memory_order_acq_rel, std::memory_order_acquire))
+			break;
+	}
+
+	taskFunction.load(std::memory_order_relaxed)(taskContext.load(std::memory_order_relaxed), (int)(current & maxTasks));
+	completed.fetch_add(1, std::memory_order_release);
+	return true;
+}
@@ -0,0 +1,88 @@
+/*
+  ==============================================================================
+
+	Small pool of real-time worker threads for processing bands in parallel.
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+
+//==============================================================================
+/**
+	Runs the independent tasks of one job (one per band) across a few
+	pre-spawned real-time threads, with the calling audio thread joining in.
+
+	Tasks are claimed by compare-and-swap on a single word holding the job's
+	generation, task count and next task index, all published at once, so a
+	worker that wakes late for an old job can never take a task from a new one
+	and every task runs exactly once. The audio thread never allocates,
+	locks or calls into the OS: it publishes the job, works through whatever
+	tasks are left and spins until the ones claimed by workers are done.
+
+	Idle workers spin, then yield, then park, polling for the next job every
+	millisecond. Nothing ever signals them, so publishing a job is one atomic
+	store; and since the caller works through the tasks itself, it never waits
+	on a worker that is still waking up.
+
+	The workers only exist while enabled. setEnabled() may be called while the
+	audio thread is in run(): a job that finds the pool disabled simply runs
+	all its tasks on the calling thread.
+*/
+class BandWorkerPool
+{
+public:
+	BandWorkerPool();
+	~BandWorkerPool();
+
+	/** Sets the number of workers and their timing; call from prepareToPlay, never from the audio thread. */
+	void prepare(int numWorkers, int expectedBlockSize, double sampleRate);
+
+	/** Message thread. Spawns or stops the workers; a no-op if already in that state. */
+	void setEnabled(bool shouldBeEnabled);
+	void stop() { setEnabled(false); }
+
+	/** Safe from any thread; 0 while disabled. */
+	int getNumWorkers() const noexcept { return numRunning.load(std::memory_order_relaxed); }
+
+	/** 1-based index of the pool worker running the calling code, or 0 for any other thread. */
+	static int getCurrentWorkerIndex() noexcept;
+
+	/** Calls task(index) for every index in [0, numTasks) and returns when all are done. */
+	template <typename Task>
+	void run(int numTasks, Task& task) noexcept
+	{
+		dispatch(numTasks, [](void* context, int index) { (*static_cast<Task*>(context))(index); }, &task);
+	}
+
+private:
+	using TaskFunction = void (*)(void*, int);
+
+	class Worker;
+
+	void dispatch(int numTasks, TaskFunction function, void* context) noexcept;
+	bool runNextTask(juce::uint32 generation) noexcept;
+	juce::uint32 getGeneration() const noexcept;
+
+	juce::OwnedArray<Worker> workers;
+	int numWorkersWanted = 0, blockSize = 512;
+	double workerSampleRate = 44100.0;
+
+	// run() raises dispatching before checking available; setEnabled() clears
+	// available and waits for dispatching to drop before touching the workers.
+	std::atomic<bool> available{ false }, dispatching{ false };
+	std::atomic<int> numRunning{ 0 };
+
+	// Generation in the upper 32 bits, then the task count and the next unclaimed
+	// task index in 16 bits each. The function and context are stored before the
+	// word is published and only read after a claim in its generation succeeds.
+	static constexpr int maxTasks = 0xffff;
+	std::atomic<juce::uint64> cursor{ 0 };
+	std::atomic<int> completed{ 0 };
+	std::atomic<TaskFunction> taskFunction{ nullptr };
+	std::atomic<void*> taskContext{ nullptr };
+
+	JUCE_DECLARE_NON_COPYABLE(BandWorkerPool)
+};
@@ -0,0 +1,150 @@
+/*
+  ==============================================================================
+
+	Snapshot of the parameter values the DSP chain is built from.
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+
+constexpr int maxBands = 6;
+
+/** Cut filter slopes; each step adds one Butterworth biquad section. */
+enum Slope
+{
+	Slope_12,
+	Slope_24,
+	Slope_36,
+	Slope_48
+};
+
+constexpr int maxCutStages = 4;
+constexpr int getNumCutStages(Slope slope) noexcept { return (int)slope + 1; }
+
+/** Partition sizes of the linear-phase crossover, as powers of two: 64 to 2048 samples. */
+constexpr int minCrossoverPartitionOrder = 6, maxCrossoverPartitionOrder = 11;
+constexpr int defaultCrossoverPartitionOrder = 9;
+
+constexpr std::array<float, maxBands - 1> defaultCrossoverFreqs{ 100.f, 500.f, 2000.f, 6000.f, 12000.f };
+
+/** The cut frequency range; a cut at the far end of it is off rather than filtering at 20 Hz or 20 kHz. */
+constexpr float minimumCutFreq = 20.f, maximumCutFreq = 20000.f;
+
+/** LFOs and macros, routed to their targets through a fixed number of slots. */
+constexpr int numLfos = 2, numMacros = 2, numModulationSlots = 4;
+
+/** A slot's source choice: off, then the LFOs, then the macros. */
+constexpr int getLfoSource(int lfo) noexcept { return 1 + lfo; }
+constexpr int getMacroSource(int macro) noexcept { return 1 + numLfos + macro; }
+
+/** A slot's target choice; the crossovers and bands each take a run of values. */
+enum ModulationTarget
+{
+	Target_PeakGain,
+	Target_PeakFreq,
+	Target_PeakQuality,
+	Target_Crossover,
+	Target_BandDrive = Target_Crossover + maxBands - 1,
+	Target_BandMix = Target_BandDrive + maxBands,
+	numModulationTargets = Target_BandMix + maxBands
+};
+
+struct ModulationSlot
+{
+	int source{ 0 };
+	int target{ Target_PeakGain };
+
+	/** -1 to 1 of the target's modulation range. */
+	float depth{ 0 };
+};
+
+inline bool operator==(const ModulationSlot& a, const ModulationSlot& b) noexcept
+{
+	return a.source == b.source && a.target == b.target && a.depth == b.depth;
+}
+
+struct ChainSettings
+{
+	float peakFreq{ 1200 }, peakGainInDecibels{ 0 }, peakQuality{ 0.1f };
+	float lowCutFreq{ 20 }, highCutFreq{ 20000 };
+	Slope lowCutSlope{ Slope_12 }, highCutSlope{ Slope_12 };
+
+	int numBands{ 3 };
+	std::array<float, maxBands - 1> crossoverFreqs{ defaultCrossoverFreqs };
+	bool linearPhaseCrossover{ false };
+	int crossoverPartitionOrder{ defaultCrossoverPartitionOrder };
+	std::array<float, maxBands> bandDriveInDecibels{};
+	std::array<float, maxBands> bandMix{ 1.f, 1.f, 1.f, 1.f, 1.f, 1.f };
+	std::array<int, maxBands> bandCurves{};
+
+	// How far each band's envelope moves its drive, and how the envelope is followed.
+	std::array<float, maxBands> bandDynamicsInDecibels{};
+	bool rmsEnvelope{ false };
+	float envelopeAttackMilliseconds{ 5 }, envelopeReleaseMilliseconds{ 100 };
+
+	// 0 follows every channel on its own; 1 and 2 follow the max or mean of all of them.
+	int envelopeLink{ 0 };
+
+	// Control-rate modulation: how often the modulators are evaluated, and what they do.
+	int modulationInterval{ 32 };
+	std::array<float, numLfos> lfoRates{ 1.f, 1.f };
+	std::array<int, numLfos> lfoShapes{};
+	std::array<float, numMacros> macros{};
+	std::array<ModulationSlot, numModulationSlots> modulationSlots{};
+
+	int oversamplingStages{ 0 };
+	bool linearPhaseOversampling{ false };
+	int antialiasingMode{ 0 };
+
+	bool parallelBands{ false };
+};
+
+inline bool operator==(const ChainSettings& a, const ChainSettings& b) noexcept
+{
+	return a.peakFreq == b.peakFreq
+		&& a.peakGainInDecibels == b.peakGainInDecibels
+		&& a.peakQuality == b.peakQuality
+		&& a.lowCutFreq == b.lowCutFreq
+		&& a.highCutFreq == b.highCutFreq
+		&& a.lowCutSlope == b.lowCutSlope
+		&& a.highCutSlope == b.highCutSlope
+		&& a.numBands == b.numBands
+		&& a.crossoverFreqs == b.crossoverFreqs
+		&& a.linearPhaseCrossover == b.linearPhaseCrossover
+		&& a.crossoverPartitionOrder == b.crossoverPartitionOrder
+		&& a.bandDriveInDecibels == b.bandDriveInDecibels
+		&& a.bandMix == b.bandMix
+		&& a.bandCurves == b.bandCurves
+		&& a.bandDynamicsInDecibels == b.bandDynamicsInDecibels
+		&& a.rmsEnvelope == b.rmsEnvelope
+		&& a.envelopeAttackMilliseconds == b.envelopeAttackMilliseconds
+		&& a.envelopeReleaseMilliseconds == b.envelopeReleaseMilliseconds
+		&& a.envelopeLink == b.envelopeLink
+		&& a.modulationInterval == b.modulationInterval
+		&& a.lfoRates == b.lfoRates
+		&& a.lfoShapes == b.lfoShapes
+		&& a.macros == b.macros
+		&& a.modulationSlots == b.modulationSlots
+		&& a.oversamplingStages == b.oversamplingStages
+		&& a.linearPhaseOversampling == b.linearPhaseOversampling
+		&& a.antialiasingMode == b.antialiasingMode
+		&& a.parallelBands == b.parallelBands;
+}
+
+inline bool operator!=(const ChainSettings& a, const ChainSettings& b) noexcept
+{
+	return !(a == b);
+}
+
+inline int getNumLowCutStages(const ChainSettings& settings) noexcept
+{
+	return settings.lowCutFreq <= minimumCutFreq ? 0 : getNumCutStages(settings.lowCutSlope);
+}
+
+inline int getNumHighCutStages(const ChainSettings& settings) noexcept
+{
+	return settings.highCutFreq >= maximumCutFreq ? 0 : getNumCutStages(settings.highCutSlope);
+}
@@ -0,0 +1,279 @@
+/*
+  ==============================================================================
+
+	The DSP state for one SIMD register's worth of channels.
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+#include "ChainSettings.h"
+#include "CoefficientEngine.h"
+#include "SIMDInterleaver.h"
+#include "Crossover.h"
+#include "LinearPhaseCrossover.h"
+#include "DistortionBand.h"
+
+enum ChainPositions
+{
+	LowCut,
+	Peak,
+	HighCut
+};
+
+//==============================================================================
+/**
+	Everything the processor keeps per channel, for up to Register::size()
+	consecutive channels of the bus, one channel per lane.
+
+	The processor allocates as many groups as the layout needs in prepareToPlay,
+	so a mono bus costs one group and a 7.1.4 bus three with SSE. Every group is
+	driven with the same settings; interleave() and deinterleave() move the
+	group's channels in and out of its own SIMD block.
+
+	The cut filters always hold maxCutStages biquads, but only the stages the
+	slope needs are visited: processCut() picks one of maxCutStages
+	instantiations per block, each of which runs a fixed number of stages.
+*/
+template <typename FloatType>
+struct ChannelGroup
+{
+	using Register = juce::dsp::SIMDRegister<FloatType>;
+	using Filter = juce::dsp::IIR::Filter<Register>;
+	using Cutfilter = juce::dsp::ProcessorChain<Filter, Filter, Filter, Filter>;
+	using Monochain = juce::dsp::ProcessorChain<Cutfilter, Filter, Cutfilter>;
+
+	static constexpr size_t numLanes = Register::size();
+
+	explicit ChannelGroup(size_t firstChannelOfGroup) noexcept
+		: firstChannel(firstChannelOfGroup)
+	{
+	}
+
+	void prepare(double sampleRate, int maximumBlockSize)
+	{
+		juce::dsp::ProcessSpec spec;
+		spec.maximumBlockSize = (juce::uint32)maximumBlockSize;
+		spec.numChannels = 1;
+		spec.sampleRate = sampleRate;
+		chain.prepare(spec);
+		interleaver.prepare(maximumBlockSize);
+		dry = juce::dsp::AudioBlock<Register>(dryData, 1, (size_t)maximumBlockSize);
+		crossover.prepare(sampleRate, maximumBlockSize);
+		linearPhaseCrossover.prepare(sampleRate, maximumBlockSize);
+
+		for (auto& band : bands)
+			band.prepare(sampleRate, maximumBlockSize);
+	}
+
+	/** Clears every filter, crossover and band, as if nothing had been played yet. */
+	void reset() noexcept
+	{
+		chain.reset();
+		crossover.reset();
+		linearPhaseCrossover.reset();
+
+		for (auto& band : bands)
+			band.reset();
+	}
+
+	/** Packs this group's channels of the bus into lanes; channels past the end of the bus are silent. */
+	juce::dsp::AudioBlock<Register> interleave(const juce::dsp::AudioBlock<FloatType>& bus) noexcept
+	{
+		numActiveLanes = getNumChannels(bus);
+		block = interleaver.interleave(bus.getSubsetChannelBlock(firstChannel, numActiveLanes));
+		return block;
+	}
+
+	void deinterleave(const juce::dsp::AudioBlock<FloatType>& bus) const noexcept
+	{
+		interleaver.deinterleave(bus.getSubsetChannelBlock(firstChannel, getNumChannels(bus)));
+	}
+
+	/**
+		Splits block into bands with the linear-phase kernels, or with the IIR
+		crossover when kernels is null. Whichever one is switched to starts from
+		silence.
+	*/
+	void split(const LinearPhaseKernels::KernelSet* kernels) noexcept
+	{
+		if (kernels == nullptr)
+		{
+			if (linearPhase)
+				crossover.reset();
+
+			crossover.split(block);
+		}
+		else
+		{
+			if (!linearPhase)
+				linearPhaseCrossover.reset();
+
+			linearPhaseCrossover.split(block, *kernels);
+		}
+
+		linearPhase = kernels != nullptr;
+	}
+
+	int getNumBands() const noexcept
+	{
+		return linearPhase ? linearPhaseCrossover.getNumBands() : crossover.getNumBands();
+	}
+
+	juce::dsp::AudioBlock<Register> getBand(int band, size_t numSamples) const noexcept
+	{
+		return linearPhase ? linearPhaseCrossover.getBand(band, numSamples) : crossover.getBand(band, numSamples);
+	}
+
+	/** Writes a coefficient set into a filter's existing storage; no new object is created. */
+	template <typename NumericType>
+	static void updateCoefficients(juce::dsp::IIR::Coefficients<NumericType>& old, const CoefficientEngine::CoefficientArray& replacements) noexcept
+	{
+		std::array<NumericType, 6> converted;
+
+		for (size_t i = 0; i < converted.size(); ++i)
+			converted[i] = (NumericType)replacements[i];
+
+		old = converted;
+	}
+
+	/** Installs every stage's section, including the pass-through ones, so no stage ever changes order. */
+	static void updateCutFilter(Cutfilter& cut, const CoefficientEngine::CutCoefficients& sections) noexcept
+	{
+		forEachStage(cut, [&](Filter& filter, size_t stage) { updateCoefficients(*filter.coefficients, sections[stage]); });
+	}
+
+	/**
+		Changes how many stages run. Stages that keep running keep their state, so
+		the signal stays continuous; stages that start running start from silence
+		rather than from whatever they held when they were last used.
+	*/
+	void setCutStages(const ChainSettings& settings) noexcept
+	{
+		activateStages(chain.template get<ChainPositions::LowCut>(), numLowCutStages, getNumLowCutStages(settings));
+		activateStages(chain.template get<ChainPositions::HighCut>(), numHighCutStages, getNumHighCutStages(settings));
+	}
+
+	/** Keeps a copy of the block's input for crossfadeWithDry(). */
+	void storeDry(size_t numSamples) noexcept
+	{
+		dry.getSubBlock(0, numSamples).copyFrom(block.getSubBlock(0, numSamples));
+	}
+
+	/** Blends the stored input back in, with the processed level moving linearly from startLevel to endLevel. */
+	void crossfadeWithDry(size_t numSamples, FloatType startLevel, FloatType endLevel) noexcept
+	{
+		auto* wet = block.getChannelPointer(0);
+		const auto* input = dry.getChannelPointer(0);
+		const auto step = (endLevel - startLevel) / (FloatType)juce::jmax((size_t)1, numSamples);
+		auto level = startLevel;
+
+		for (size_t i = 0; i < numSamples; ++i)
+		{
+			level += step;
+			wet[i] = input[i] + (wet[i] - input[i]) * level;
+		}
+	}
+
+	template <typename Context>
+	static void processCut(Cutfilter& cut, int numStages, const Context& context) noexcept
+	{
+		switch (numStages)
+		{
+			case 1: processStages(cut, context, std::make_index_sequence<1>()); break;
+			case 2: processStages(cut, context, std::make_index_sequence<2>()); break;
+			case 3: processStages(cut, context, std::make_index_sequence<3>()); break;
+			case 4: processStages(cut, context, std::make_index_sequence<4>()); break;
+			default: break;
+		}
+	}
+
+	/** As processCut(), with every running stage's coefficients ramped per sample, landing on the targets. */
+	static void processCutRamped(Cutfilter& cut, int numStages, const CoefficientEngine::CutCoefficients& from,
+		const CoefficientEngine::CutCoefficients& to, Register* samples, int numSamples) noexcept
+	{
+		switch (numStages)
+		{
+			case 1: processStagesRamped(cut, from, to, samples, numSamples, std::make_index_sequence<1>()); break;
+			case 2: processStagesRamped(cut, from, to, samples, numSamples, std::make_index_sequence<2>()); break;
+			case 3: processStagesRamped(cut, from, to, samples, numSamples, std::make_index_sequence<3>()); break;
+			case 4: processStagesRamped(cut, from, to, samples, numSamples, std::make_index_sequence<4>()); break;
+			default: break;
+		}
+
+		updateCutFilter(cut, to);
+	}
+
+	const size_t firstChannel;
+
+	Monochain chain;
+	SIMDInterleaver<FloatType> interleaver;
+	MultibandCrossover<FloatType> crossover;
+	LinearPhaseCrossover<FloatType> linearPhaseCrossover;
+	bool linearPhase = false;
+	std::array<DistortionBand<FloatType>, maxBands> bands;
+
+	// The current block's interleaved samples, and how many lanes hold a channel, set by interleave().
+	juce::dsp::AudioBlock<Register> block;
+	size_t numActiveLanes = numLanes;
+
+	int numLowCutStages = 0, numHighCutStages = 0;
+
+private:
+	juce::HeapBlock<char> dryData;
+	juce::dsp::AudioBlock<Register> dry;
+
+	template <typename Function>
+	static void forEachStage(Cutfilter& cut, Function&& function) noexcept
+	{
+		forEachStage(cut, function, std::make_index_sequence<maxCutStages>());
+	}
+
+	template <typename Function, size_t... Stages>
+	static void forEachStage(Cutfilter& cut, Function& function, std::index_sequence<Stages...>) noexcept
+	{
+		(function(cut.template get<Stages>(), Stages), ...);
+	}
+
+	static void activateStages(Cutfilter& cut, int& numActive, int numStages) noexcept
+	{
+		forEachStage(cut, [&](Filter& filter, size_t stage)
+		{
+			if ((int)stage >= numActive && (int)stage < numStages)
+				filter.reset();
+		});
+
+		numActive = numStages;
+	}
+
+	template <typename Context, size_t... Stages>
+	static void processStages(Cutfilter& cut, const Context& context, std::index_sequence<Stages...>) noexcept
+	{
+		(cut.template get<Stages>().process(context), ...);
+	}
+
+	template <size_t... Stages>
+	static void processStagesRamped(Cutfilter& cut, const CoefficientEngine::CutCoefficients& from,
+		const CoefficientEngine::CutCoefficients& to, Register* samples, int numSamples, std::index_sequence<Stages...>) noexcept
+	{
+		std::array<CoefficientRamp<FloatType>, sizeof...(Stages)> ramps;
+		(ramps[Stages].start(from[Stages], to[Stages], numSamples), ...);
+
+		for (int i = 0; i < numSamples; ++i)
+		{
+			auto sample = samples[i];
+			((ramps[Stages].next(cut.template get<Stages>().coefficients->getRawCoefficients()),
+				sample = cut.template get<Stages>().processSample(sample)), ...);
+			samples[i] = sample;
+		}
+	}
+
+	size_t getNumChannels(const juce::dsp::AudioBlock<FloatType>& bus) const noexcept
+	{
+		return juce::jmin(numLanes, bus.getNumChannels() - juce::jmin(bus.getNumChannels(), firstChannel));
+	}
+
+	JUCE_DECLARE_NON_COPYABLE(ChannelGroup)
+};
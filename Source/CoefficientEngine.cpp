@@ -0,0 +1,330 @@
+/*
+  ==============================================================================
+
+	Change-driven coefficient builder for the processing chain.
+
+  ==============================================================================
+*/
+
+#include "CoefficientEngine.h"
+#include "LinearPhaseCrossover.h"
+
+namespace
+{
+	/** Samples for a biquad's impulse response to fall to the tail threshold, from its largest pole radius. */
+	double getDecayInSamples(const CoefficientEngine::CoefficientArray& c) noexcept
+	{
+		const auto a1 = c[4] / c[3];
+		const auto a2 = c[5] / c[3];
+		const auto discriminant = a1 * a1 - 4.0 * a2;
+
+		const auto radius = discriminant < 0.0 ? std::sqrt(a2)
+			: 0.5 * (std::abs(a1) + std::sqrt(discriminant));
+
+		if (radius <= 0.0)
+			return 0.0;
+
+		return std::log(CoefficientEngine::tailThreshold) / std::log(juce::jmin(radius, 1.0 - 1.0e-9));
+	}
+}
+
+CoefficientEngine::CoefficientEngine(juce::AudioProcessorValueTreeState& state)
+	: apvts(state), parameterValues(state)
+{
+	for (auto* parameter : apvts.processor.getParameters())
+		if (auto* ranged = dynamic_cast<juce::RangedAudioParameter*>(parameter))
+			apvts.addParameterListener(ranged->paramID, this);
+}
+
+CoefficientEngine::~CoefficientEngine()
+{
+	for (auto* parameter : apvts.processor.getParameters())
+		if (auto* ranged = dynamic_cast<juce::RangedAudioParameter*>(parameter))
+			apvts.removeParameterListener(ranged->paramID, this);
+}
+
+void CoefficientEngine::prepare(double newSampleRate)
+{
+	sampleRate = newSampleRate;
+	needsRebuild = true;
+
+	peakFreq.reset(sampleRate, rampTimeSeconds);
+	peakQuality.reset(sampleRate, rampTimeSeconds);
+	peakGainInDecibels.reset(sampleRate, rampTimeSeconds);
+	lowCutFreq.reset(sampleRate, rampTimeSeconds);
+	highCutFreq.reset(sampleRate, rampTimeSeconds);
+
+	parametersChanged.store(true);
+	holdingSnapshot = false;
+	beginBlock();
+}
+
+bool CoefficientEngine::beginBlock() noexcept
+{
+	rampInterval = 16 << juce::jlimit(0, 2, (int)getValue(Param::RampInterval));
+	rampMode = getValue(Param::RampMode) >= 0.5f ? RampMode::PerSample : RampMode::SubBlock;
+
+	if (holdingSnapshot)
+		return false;
+
+	// Clear the flag before reading so a change landing mid-read is picked up next block.
+	if (!parametersChanged.exchange(false, std::memory_order_acquire))
+		return false;
+
+	auto targets = makeChainSettings([this](Param param, int index) { return getValue(param, index); });
+	peakFreq.setTargetValue(targets.peakFreq);
+	peakQuality.setTargetValue(targets.peakQuality);
+	peakGainInDecibels.setTargetValue(targets.peakGainInDecibels);
+	lowCutFreq.setTargetValue(targets.lowCutFreq);
+	highCutFreq.setTargetValue(targets.highCutFreq);
+
+	// A slope change swaps which stages run rather than ramping anything.
+	if (targets.lowCutSlope != settings.lowCutSlope || targets.highCutSlope != settings.highCutSlope)
+	{
+		settings.lowCutSlope = targets.lowCutSlope;
+		settings.highCutSlope = targets.highCutSlope;
+		slopesChanged = true;
+	}
+
+	// The band stage smooths its own drive and mix, so these are taken as they are.
+	settings.numBands = targets.numBands;
+	settings.crossoverFreqs = targets.crossoverFreqs;
+	settings.linearPhaseCrossover = targets.linearPhaseCrossover;
+	settings.crossoverPartitionOrder = targets.crossoverPartitionOrder;
+	settings.bandDriveInDecibels = targets.bandDriveInDecibels;
+	settings.bandMix = targets.bandMix;
+	settings.bandCurves = targets.bandCurves;
+	settings.bandDynamicsInDecibels = targets.bandDynamicsInDecibels;
+	settings.rmsEnvelope = targets.rmsEnvelope;
+	settings.envelopeAttackMilliseconds = targets.envelopeAttackMilliseconds;
+	settings.envelopeReleaseMilliseconds = targets.envelopeReleaseMilliseconds;
+	settings.envelopeLink = targets.envelopeLink;
+	settings.modulationInterval = targets.modulationInterval;
+	settings.lfoRates = targets.lfoRates;
+	settings.lfoShapes = targets.lfoShapes;
+	settings.macros = targets.macros;
+	settings.modulationSlots = targets.modulationSlots;
+	settings.oversamplingStages = targets.oversamplingStages;
+	settings.linearPhaseOversampling = targets.linearPhaseOversampling;
+	settings.antialiasingMode = targets.antialiasingMode;
+	settings.parallelBands = targets.parallelBands;
+	return true;
+}
+
+bool CoefficientEngine::advance(int numSamples) noexcept
+{
+	const auto jumped = needsRebuild;
+
+	if (needsRebuild)
+	{
+		peakFreq.setCurrentAndTargetValue(peakFreq.getTargetValue());
+		peakQuality.setCurrentAndTargetValue(peakQuality.getTargetValue());
+		peakGainInDecibels.setCurrentAndTargetValue(peakGainInDecibels.getTargetValue());
+		lowCutFreq.setCurrentAndTargetValue(lowCutFreq.getTargetValue());
+		highCutFreq.setCurrentAndTargetValue(highCutFreq.getTargetValue());
+		needsRebuild = false;
+	}
+	else if (isRamping())
+	{
+		peakFreq.skip(numSamples);
+		peakQuality.skip(numSamples);
+		peakGainInDecibels.skip(numSamples);
+		lowCutFreq.skip(numSamples);
+		highCutFreq.skip(numSamples);
+	}
+	else if (!slopesChanged)
+	{
+		if (!peakModulationChanged)
+			return false;
+
+		// Only the modulation moved, so the cuts keep their coefficients and have nothing to ramp.
+		buildPeakCoefficients();
+		previousLowCutCoefficients = lowCutCoefficients;
+		previousHighCutCoefficients = highCutCoefficients;
+		return true;
+	}
+
+	settings.peakFreq = peakFreq.getCurrentValue();
+	settings.peakQuality = peakQuality.getCurrentValue();
+	settings.peakGainInDecibels = peakGainInDecibels.getCurrentValue();
+	settings.lowCutFreq = lowCutFreq.getCurrentValue();
+	settings.highCutFreq = highCutFreq.getCurrentValue();
+
+	buildCoefficients();
+
+	if (jumped)
+		previousPeakCoefficients = peakCoefficients;
+
+	// Sections from another slope have other Qs, so there is nothing to ramp from.
+	if (jumped || slopesChanged)
+	{
+		previousLowCutCoefficients = lowCutCoefficients;
+		previousHighCutCoefficients = highCutCoefficients;
+		slopesChanged = false;
+	}
+
+	return true;
+}
+
+bool CoefficientEngine::isRamping() const noexcept
+{
+	return peakFreq.isSmoothing() || peakQuality.isSmoothing() || peakGainInDecibels.isSmoothing()
+		|| lowCutFreq.isSmoothing() || highCutFreq.isSmoothing();
+}
+
+CoefficientEngine::Snapshot CoefficientEngine::makeSnapshot(const ChainSettings& settings, double sampleRate) noexcept
+{
+	Snapshot snapshot;
+	snapshot.settings = settings;
+	snapshot.peak = juce::dsp::IIR::ArrayCoefficients<double>::makePeakFilter(sampleRate,
+		(double)settings.peakFreq,
+		(double)settings.peakQuality,
+		juce::Decibels::decibelsToGain((double)settings.peakGainInDecibels));
+
+	makeCutCoefficients(snapshot.lowCut, sampleRate, (double)settings.lowCutFreq, settings.lowCutSlope, true);
+	makeCutCoefficients(snapshot.highCut, sampleRate, (double)settings.highCutFreq, settings.highCutSlope, false);
+	return snapshot;
+}
+
+void CoefficientEngine::applySnapshot(const Snapshot& snapshot) noexcept
+{
+	settings = snapshot.settings;
+	peakFreq.setCurrentAndTargetValue(settings.peakFreq);
+	peakQuality.setCurrentAndTargetValue(settings.peakQuality);
+	peakGainInDecibels.setCurrentAndTargetValue(settings.peakGainInDecibels);
+	lowCutFreq.setCurrentAndTargetValue(settings.lowCutFreq);
+	highCutFreq.setCurrentAndTargetValue(settings.highCutFreq);
+
+	peakCoefficients = previousPeakCoefficients = snapshot.peak;
+	lowCutCoefficients = previousLowCutCoefficients = snapshot.lowCut;
+	highCutCoefficients = previousHighCutCoefficients = snapshot.highCut;
+
+	needsRebuild = false;
+	slopesChanged = false;
+	holdingSnapshot = true;
+
+	// The snapshot's coefficients are unmodulated; the modulators reapply theirs on their next tick.
+	peakModulation = {};
+	peakModulationChanged = false;
+
+	// A controller's value from before the switch mustn't carry over into the program.
+	controlled.fill(false);
+}
+
+void CoefficientEngine::setControllerValue(int slot, float value) noexcept
+{
+	controllerValues[(size_t)slot] = value;
+	controlled[(size_t)slot] = true;
+	parametersChanged.store(true, std::memory_order_release);
+}
+
+void CoefficientEngine::releaseController(int slot) noexcept
+{
+	controlled[(size_t)slot] = false;
+	parametersChanged.store(true, std::memory_order_release);
+}
+
+void CoefficientEngine::setPeakModulation(const PeakModulation& newModulation) noexcept
+{
+	if (newModulation == peakModulation)
+		return;
+
+	peakModulation = newModulation;
+	peakModulationChanged = true;
+}
+
+bool CoefficientEngine::isNeutral() const noexcept
+{
+	return !isRamping()
+		&& settings.peakGainInDecibels == 0.f
+		&& peakModulation.gainInDecibels == 0.f
+		&& getNumLowCutStages(settings) == 0
+		&& getNumHighCutStages(settings) == 0;
+}
+
+double CoefficientEngine::getTailInSamples() const noexcept
+{
+	auto tail = getDecayInSamples(peakCoefficients);
+
+	for (int stage = 0; stage < getNumLowCutStages(settings); ++stage)
+		tail += getDecayInSamples(lowCutCoefficients[(size_t)stage]);
+
+	for (int stage = 0; stage < getNumHighCutStages(settings); ++stage)
+		tail += getDecayInSamples(highCutCoefficients[(size_t)stage]);
+
+	// The FIR crossover rings for half its kernel after the delay the processor
+	// already adds as latency.
+	if (settings.linearPhaseCrossover)
+		return tail + (double)(LinearPhaseKernels::getNumTaps(sampleRate) / 2);
+
+	// Each crossover is two Butterworth sections in series, and the bands below it
+	// also go through an allpass with the same poles.
+	for (int i = 0; i < juce::jlimit(2, maxBands, settings.numBands) - 1; ++i)
+	{
+		const auto frequency = juce::jlimit(10.0, sampleRate * 0.45, (double)settings.crossoverFreqs[(size_t)i]);
+		tail += 3.0 * getDecayInSamples(juce::dsp::IIR::ArrayCoefficients<double>::makeLowPass(sampleRate, frequency,
+			juce::MathConstants<double>::sqrt2 * 0.5));
+	}
+
+	return tail;
+}
+
+void CoefficientEngine::buildCoefficients() noexcept
+{
+	buildPeakCoefficients();
+
+	previousLowCutCoefficients = lowCutCoefficients;
+	previousHighCutCoefficients = highCutCoefficients;
+	makeCutCoefficients(lowCutCoefficients, sampleRate, (double)settings.lowCutFreq, settings.lowCutSlope, true);
+	makeCutCoefficients(highCutCoefficients, sampleRate, (double)settings.highCutFreq, settings.highCutSlope, false);
+}
+
+void CoefficientEngine::buildPeakCoefficients() noexcept
+{
+	const auto& gainRange = getDescriptor(Param::PeakGain);
+	const auto gainInDecibels = juce::jlimit(gainRange.minimum, gainRange.maximum, settings.peakGainInDecibels + peakModulation.gainInDecibels);
+
+	previousPeakCoefficients = peakCoefficients;
+	peakCoefficients = juce::dsp::IIR::ArrayCoefficients<double>::makePeakFilter(sampleRate,
+		juce::jlimit(10.0, sampleRate * 0.45, (double)(settings.peakFreq * peakModulation.frequencyRatio)),
+		juce::jlimit(0.025, 40.0, (double)(settings.peakQuality * peakModulation.qualityRatio)),
+		juce::Decibels::decibelsToGain((double)gainInDecibels));
+
+	peakModulationChanged = false;
+}
+
+void CoefficientEngine::makeCutCoefficients(CutCoefficients& sections, double sampleRate, double frequency, Slope slope, bool highPass) noexcept
+{
+	using Coefficients = juce::dsp::IIR::ArrayCoefficients<double>;
+
+	const auto numStages = getNumCutStages(slope);
+	const auto order = 2.0 * numStages;
+	frequency = juce::jlimit(10.0, sampleRate * 0.45, frequency);
+
+	// An order-2n Butterworth response is n biquads with Q = 1 / (2 cos((2k + 1) pi / 4n)).
+	for (int stage = 0; stage < maxCutStages; ++stage)
+	{
+		auto& section = sections[(size_t)stage];
+
+		if (stage >= numStages)
+		{
+			section = { 1.0, 0.0, 0.0, 1.0, 0.0, 0.0 };
+			continue;
+		}
+
+		const auto quality = 1.0 / (2.0 * std::cos(juce::MathConstants<double>::pi * (2 * stage + 1) / (2.0 * order)));
+		section = highPass ? Coefficients::makeHighPass(sampleRate, frequency, quality)
+			: Coefficients::makeLowPass(sampleRate, frequency, quality);
+	}
+}
+
+void CoefficientEngine::parameterChanged(const juce::String&, float)
+{
+	parametersChanged.store(true, std::memory_order_release);
+}
+
+float CoefficientEngine::getValue(Param param, int index) const noexcept
+{
+	const auto slot = (size_t)getParameterSlot(param, index);
+	return controlled[slot] ? controllerValues[slot] : parameterValues(param, index);
+}
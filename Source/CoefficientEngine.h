@@ -0,0 +1,196 @@
+/*
+  ==============================================================================
+
+	Change-driven coefficient builder for the processing chain.
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+#include "ChainSettings.h"
+#include "ParameterRegistry.h"
+
+//==============================================================================
+/**
+	Rebuilds the filter coefficients only when a parameter has actually changed.
+
+	Parameter callbacks (which may arrive on any thread) only raise an atomic flag.
+	The audio thread picks the flag up in beginBlock(), reads the parameters through
+	a ParameterValues and ramps towards them with SmoothedValues.
+	advance() rebuilds the coefficients into plain arrays for the values reached,
+	so the processBlock path never allocates and never locks.
+*/
+class CoefficientEngine : private juce::AudioProcessorValueTreeState::Listener
+{
+public:
+	// Built in double precision; the float path rounds them when it installs them.
+	using CoefficientArray = std::array<double, 6>;
+
+	/** One section per cut stage; stages the slope doesn't use hold a pass-through biquad. */
+	using CutCoefficients = std::array<CoefficientArray, maxCutStages>;
+
+	/** Settings with their coefficients already built, for jumping straight to a program. */
+	struct Snapshot
+	{
+		ChainSettings settings;
+		CoefficientArray peak{};
+		CutCoefficients lowCut{}, highCut{};
+	};
+
+	enum class RampMode
+	{
+		SubBlock,
+		PerSample
+	};
+
+	/** What the modulators add to the peak on top of its ramped settings. */
+	struct PeakModulation
+	{
+		float gainInDecibels = 0.f, frequencyRatio = 1.f, qualityRatio = 1.f;
+
+		bool operator==(const PeakModulation& other) const noexcept
+		{
+			return gainInDecibels == other.gainInDecibels && frequencyRatio == other.frequencyRatio && qualityRatio == other.qualityRatio;
+		}
+	};
+
+	explicit CoefficientEngine(juce::AudioProcessorValueTreeState& apvts);
+	~CoefficientEngine() override;
+
+	/** Call from prepareToPlay; the next advance() jumps straight to the current values. */
+	void prepare(double newSampleRate);
+
+	/** Audio thread. Picks up parameter changes as new ramp targets; returns true if there were any. */
+	bool beginBlock() noexcept;
+
+	/** Audio thread. Moves the ramps on by numSamples and returns true if new coefficients were built. */
+	bool advance(int numSamples) noexcept;
+
+	bool isRamping() const noexcept;
+
+	static Snapshot makeSnapshot(const ChainSettings& settings, double sampleRate) noexcept;
+
+	/**
+		Audio thread. Jumps to a snapshot without ramping, then leaves parameter
+		changes alone until releaseSnapshot(), so parameters that haven't caught
+		up with the snapshot yet can't pull it back.
+	*/
+	void applySnapshot(const Snapshot& snapshot) noexcept;
+	void releaseSnapshot() noexcept { holdingSnapshot = false; }
+
+	/**
+		Audio thread. Overrides one parameter slot with a value a controller has set,
+		ahead of the parameter itself; the next beginBlock() picks it up. Lasts until
+		releaseController() or the next snapshot.
+	*/
+	void setControllerValue(int slot, float value) noexcept;
+	void releaseController(int slot) noexcept;
+	bool isControlled(int slot) const noexcept { return controlled[(size_t)slot]; }
+
+	/**
+		Audio thread. Offsets the peak by a control-rate modulation value; the next
+		advance() rebuilds the peak coefficients, and only those, if it moved.
+	*/
+	void setPeakModulation(const PeakModulation& newModulation) noexcept;
+
+	/** True when the chain settles to unity gain: peak at 0 dB and unmodulated, both cuts off, nothing ramping. */
+	bool isNeutral() const noexcept;
+
+	/** How long the chain and crossovers ring for, to tailThreshold, judged from their pole radii. */
+	double getTailInSamples() const noexcept;
+
+	/** -120 dB; below this a tail counts as decayed and an input as silent. */
+	static constexpr double tailThreshold = 1.0e-6;
+	int getRampInterval() const noexcept { return rampInterval; }
+	RampMode getRampMode() const noexcept { return rampMode; }
+
+	const ChainSettings& getChainSettings() const noexcept { return settings; }
+	const CoefficientArray& getPeakCoefficients() const noexcept { return peakCoefficients; }
+	const CoefficientArray& getPreviousPeakCoefficients() const noexcept { return previousPeakCoefficients; }
+	const CutCoefficients& getLowCutCoefficients() const noexcept { return lowCutCoefficients; }
+	const CutCoefficients& getPreviousLowCutCoefficients() const noexcept { return previousLowCutCoefficients; }
+	const CutCoefficients& getHighCutCoefficients() const noexcept { return highCutCoefficients; }
+	const CutCoefficients& getPreviousHighCutCoefficients() const noexcept { return previousHighCutCoefficients; }
+
+	/** Butterworth high-pass or low-pass sections for a slope; allocation-free. */
+	static void makeCutCoefficients(CutCoefficients& sections, double sampleRate, double frequency, Slope slope, bool highPass) noexcept;
+
+	static constexpr double rampTimeSeconds = 0.05;
+
+private:
+	void parameterChanged(const juce::String& parameterID, float newValue) override;
+	float getValue(Param param, int index = 0) const noexcept;
+	void buildCoefficients() noexcept;
+	void buildPeakCoefficients() noexcept;
+
+	juce::AudioProcessorValueTreeState& apvts;
+	ParameterValues parameterValues;
+	std::array<float, (size_t)numParameterSlots> controllerValues{};
+	std::array<bool, (size_t)numParameterSlots> controlled{};
+
+	std::atomic<bool> parametersChanged{ true };
+	bool needsRebuild = true;
+	bool slopesChanged = false;
+	bool holdingSnapshot = false;
+	bool peakModulationChanged = false;
+	PeakModulation peakModulation;
+	double sampleRate = 44100.0;
+	int rampInterval = 32;
+	RampMode rampMode = RampMode::SubBlock;
+
+	juce::SmoothedValue<float, juce::ValueSmoothingTypes::Multiplicative> peakFreq{ 1200.f }, peakQuality{ 0.1f };
+	juce::SmoothedValue<float> peakGainInDecibels{ 0.f };
+	juce::SmoothedValue<float, juce::ValueSmoothingTypes::Multiplicative> lowCutFreq{ 20.f }, highCutFreq{ 20000.f };
+
+	ChainSettings settings;
+	CoefficientArray peakCoefficients{}, previousPeakCoefficients{};
+	CutCoefficients lowCutCoefficients{}, previousLowCutCoefficients{}, highCutCoefficients{}, previousHighCutCoefficients{};
+
+	JUCE_DECLARE_NON_COPYABLE(CoefficientEngine)
+};
+
+//==============================================================================
+/**
+	Steps a biquad's normalised coefficients linearly from one set to another, one
+	sample at a time. The stable (a1, a2) region of a biquad is a triangle, so every
+	intermediate filter between two stable end points is stable too.
+
+	The ramp itself runs in double precision whatever the filter's NumericType.
+*/
+template <typename NumericType>
+struct CoefficientRamp
+{
+	void start(const CoefficientEngine::CoefficientArray& from, const CoefficientEngine::CoefficientArray& to, int numSamples) noexcept
+	{
+		const auto fromNormalised = normalise(from);
+		const auto toNormalised = normalise(to);
+		const auto inverseLength = 1.0 / (double)juce::jmax(1, numSamples);
+
+		for (size_t i = 0; i < current.size(); ++i)
+		{
+			current[i] = fromNormalised[i];
+			step[i] = (toNormalised[i] - fromNormalised[i]) * inverseLength;
+		}
+	}
+
+	/** Writes the next set into a Coefficients object's raw storage (b0, b1, b2, a1, a2). */
+	void next(NumericType* rawCoefficients) noexcept
+	{
+		for (size_t i = 0; i < current.size(); ++i)
+		{
+			current[i] += step[i];
+			rawCoefficients[i] = (NumericType)current[i];
+		}
+	}
+
+private:
+	static std::array<double, 5> normalise(const CoefficientEngine::CoefficientArray& c) noexcept
+	{
+		const auto a0Inverse = 1.0 / c[3];
+		return { c[0] * a0Inverse, c[1] * a0Inverse, c[2] * a0Inverse, c[4] * a0Inverse, c[5] * a0Inverse };
+	}
+
+	std::array<double, 5> current{}, step{};
+};
@@ -0,0 +1,199 @@
+/*
+  ==============================================================================
+
+	Linkwitz-Riley band splitter for the multiband stage.
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+#include "ChainSettings.h"
+
+//==============================================================================
+/**
+	4th-order Linkwitz-Riley low/high pair built from two cascaded Butterworth
+	state-variable sections (the same topology as juce::dsp::LinkwitzRileyFilter),
+	written against a generic sample type so it runs on SIMDRegister lanes.
+
+	The low and high outputs sum to a 2nd-order allpass, which processAllpass()
+	produces directly for phase-compensating the other bands.
+*/
+template <typename SampleType, typename NumericType>
+class LinkwitzRiley4
+{
+public:
+	void setCutoffFrequency(double sampleRate, NumericType frequency) noexcept
+	{
+		g = (NumericType)std::tan(juce::MathConstants<double>::pi * frequency / sampleRate);
+		h = (NumericType)1 / ((NumericType)1 + R2 * g + g * g);
+	}
+
+	void reset() noexcept
+	{
+		s1 = s2 = s3 = s4 = SampleType();
+	}
+
+	void processSample(SampleType input, SampleType& low, SampleType& high) noexcept
+	{
+		auto yH = (input - s1 * (R2 + g) - s2) * h;
+		auto yB = yH * g + s1;
+		s1 = yH * g + yB;
+		auto yL = yB * g + s2;
+		s2 = yB * g + yL;
+
+		auto yH2 = (yL - s3 * (R2 + g) - s4) * h;
+		auto yB2 = yH2 * g + s3;
+		s3 = yH2 * g + yB2;
+		auto yL2 = yB2 * g + s4;
+		s4 = yB2 * g + yL2;
+
+		// LP4 + HP4 is the first section's allpass, so the high band falls out for free.
+		low = yL2;
+		high = yL + yH - yB * R2 - yL2;
+	}
+
+	SampleType processAllpass(SampleType input) noexcept
+	{
+		auto yH = (input - s1 * (R2 + g) - s2) * h;
+		auto yB = yH * g + s1;
+		s1 = yH * g + yB;
+		auto yL = yB * g + s2;
+		s2 = yB * g + yL;
+
+		return yL + yH - yB * R2;
+	}
+
+private:
+	static constexpr NumericType R2 = juce::MathConstants<NumericType>::sqrt2;
+
+	NumericType g{}, h{};
+	SampleType s1{}, s2{}, s3{}, s4{};
+};
+
+//==============================================================================
+/**
+	Splits a block of SIMD-interleaved samples into 2 to maxBands bands.
+
+	Bands are taken off from the bottom: each crossover splits what is left into
+	its low band and the remainder. Every band below a crossover also passes
+	through that crossover's allpass, so the bands sum back to a flat response.
+	All band storage is allocated in prepare(); split() is a single pass over
+	the block that writes every band for each sample in turn.
+*/
+template <typename FloatType>
+class MultibandCrossover
+{
+public:
+	using Register = juce::dsp::SIMDRegister<FloatType>;
+	using Filter = LinkwitzRiley4<Register, FloatType>;
+
+	void prepare(double newSampleRate, int maximumBlockSize)
+	{
+		sampleRate = newSampleRate;
+		bands = juce::dsp::AudioBlock<Register>(bandData, (size_t)maxBands, (size_t)maximumBlockSize);
+		bands.clear();
+
+		for (size_t i = 0; i < frequencies.size(); ++i)
+			updateCrossover(i);
+
+		reset();
+	}
+
+	void reset() noexcept
+	{
+		for (auto& filter : splits)
+			filter.reset();
+
+		for (auto& row : compensation)
+			for (auto& filter : row)
+				filter.reset();
+	}
+
+	void setNumBands(int newNumBands) noexcept
+	{
+		newNumBands = juce::jlimit(2, maxBands, newNumBands);
+
+		if (newNumBands != numBands)
+		{
+			numBands = newNumBands;
+			reset();
+		}
+	}
+
+	int getNumBands() const noexcept { return numBands; }
+
+	/** Crossover frequencies are kept ascending; a value below its neighbour is raised to meet it. */
+	void setCrossoverFrequency(size_t index, FloatType frequency) noexcept
+	{
+		jassert(index < frequencies.size());
+
+		if (index > 0)
+			frequency = juce::jmax(frequency, frequencies[index - 1]);
+
+		frequency = juce::jlimit((FloatType)10, (FloatType)(sampleRate * 0.45), frequency);
+
+		if (frequency != frequencies[index])
+		{
+			frequencies[index] = frequency;
+			updateCrossover(index);
+		}
+	}
+
+	void split(const juce::dsp::AudioBlock<Register>& input) noexcept
+	{
+		const auto numSamples = input.getNumSamples();
+		const auto numCrossovers = (size_t)numBands - 1;
+		jassert(numSamples <= bands.getNumSamples());
+
+		auto* in = input.getChannelPointer(0);
+
+		Register* out[maxBands];
+		for (size_t band = 0; band < (size_t)numBands; ++band)
+			out[band] = bands.getChannelPointer(band);
+
+		for (size_t i = 0; i < numSamples; ++i)
+		{
+			auto rest = in[i];
+
+			for (size_t c = 0; c < numCrossovers; ++c)
+			{
+				Register low, high;
+				splits[c].processSample(rest, low, high);
+
+				for (size_t later = c + 1; later < numCrossovers; ++later)
+					low = compensation[c][later].processAllpass(low);
+
+				out[c][i] = low;
+				rest = high;
+			}
+
+			out[numCrossovers][i] = rest;
+		}
+	}
+
+	juce::dsp::AudioBlock<Register> getBand(int band, size_t numSamples) const noexcept
+	{
+		return bands.getSingleChannelBlock((size_t)band).getSubBlock(0, numSamples);
+	}
+
+private:
+	void updateCrossover(size_t index) noexcept
+	{
+		splits[index].setCutoffFrequency(sampleRate, frequencies[index]);
+
+		for (auto& row : compensation)
+			row[index].setCutoffFrequency(sampleRate, frequencies[index]);
+	}
+
+	double sampleRate = 44100.0;
+	int numBands = 2;
+
+	std::array<FloatType, maxBands - 1> frequencies{};
+	std::array<Filter, maxBands - 1> splits;
+	std::array<std::array<Filter, maxBands - 1>, maxBands - 1> compensation;
+
+	juce::HeapBlock<char> bandData;
+	juce::dsp::AudioBlock<Register> bands;
+};
@@ -0,0 +1,441 @@
+/*
+  ==============================================================================
+
+	Per-band drive and dry/wet mix for the multiband stage.
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+#include "Oversampling.h"
+#include "Waveshaper.h"
+#include "AntiderivativeShaper.h"
+#include "EnvelopeFollower.h"
+
+//==============================================================================
+/**
+	Drives one crossover band into a waveshaper and blends the result with
+	the clean band. Works in place on SIMD-interleaved samples, so every channel
+	of the band is shaped in the same pass.
+
+	The drive and the blend run inside the band's oversampler, so the dry signal
+	sees the same filters and latency as the wet one. Changing the oversampling
+	configuration primes the new oversampler, and its own ADAA state, with the
+	band's recent input, then renders through both and crossfades over
+	switchFadeSeconds however many blocks that takes. During the fade the path
+	with less latency is delayed to line up with the other, so the two never
+	comb; the jump in delay falls where the reported latency changes.
+
+	With antialiasing switched on, the curve is run through its ADAA form
+	instead, at whatever rate the oversampler leaves it.
+
+	With a dynamics range set, the band's own envelope moves the drive: it is
+	followed at the base rate before oversampling, and each oversampled sample
+	takes the multiplier of the base-rate sample it came from. Modulated drive and
+	mix reach the oversampled samples the same way.
+*/
+template <typename FloatType>
+class DistortionBand
+{
+public:
+	using Register = juce::dsp::SIMDRegister<FloatType>;
+	using Oversampler = BandOversampler<FloatType>;
+
+	void prepare(double sampleRate, int maximumBlockSize)
+	{
+		driveGain.reset(sampleRate, 0.02);
+		mix.reset(sampleRate, 0.02);
+		dynamicsRange.reset(sampleRate, 0.02);
+		driveGain.setCurrentAndTargetValue(driveGain.getTargetValue());
+		mix.setCurrentAndTargetValue(mix.getTargetValue());
+		dynamicsRange.setCurrentAndTargetValue(dynamicsRange.getTargetValue());
+
+		follower.prepare(sampleRate);
+		driveGains = juce::dsp::AudioBlock<Register>(driveGainStorage, 1, (size_t)maximumBlockSize);
+
+		for (auto& oversampler : oversamplers)
+		{
+			oversampler.prepare(maximumBlockSize);
+			oversampler.setConfiguration(pendingStages, pendingFilterType);
+		}
+
+		crossfadeData = juce::dsp::AudioBlock<Register>(crossfadeStorage, 1, (size_t)maximumBlockSize);
+		primeData = juce::dsp::AudioBlock<Register>(primeStorage, 1, (size_t)juce::jmin((int)historyLength, maximumBlockSize));
+		inputHistory = juce::dsp::AudioBlock<Register>(inputHistoryStorage, 1, historyLength);
+		delayLine = juce::dsp::AudioBlock<Register>(delayLineStorage, 1, historyLength);
+		fadeLength = juce::jmax(1, juce::roundToInt(sampleRate * switchFadeSeconds));
+
+		for (auto& antiderivative : antiderivatives)
+			antiderivative.setCurve(shaper.getCurve());
+
+		reset();
+	}
+
+	/** Clears the oversampling, ADAA and envelope state and jumps drive and mix to their targets. */
+	void reset() noexcept
+	{
+		driveGain.setCurrentAndTargetValue(driveGain.getTargetValue());
+		mix.setCurrentAndTargetValue(mix.getTargetValue());
+		dynamicsRange.setCurrentAndTargetValue(dynamicsRange.getTargetValue());
+		follower.reset();
+
+		for (auto& oversampler : oversamplers)
+			oversampler.reset();
+
+		for (auto& antiderivative : antiderivatives)
+			antiderivative.reset();
+
+		// A switch in progress lands at once; there is nothing left of the old path to fade.
+		if (fadePosition >= 0)
+			active = 1 - active;
+
+		fadePosition = -1;
+		historyFilled = 0;
+		inputHistory.clear();
+		delayLine.clear();
+	}
+
+	void setDrive(FloatType decibels) noexcept { driveGain.setTargetValue(juce::Decibels::decibelsToGain(decibels)); }
+	void setMix(FloatType proportion) noexcept { mix.setTargetValue(proportion); }
+	void setAntialiasing(AntialiasingMode mode) noexcept
+	{
+		for (auto& antiderivative : antiderivatives)
+			antiderivative.setMode(mode);
+	}
+
+	/** How far a full-scale envelope moves the drive; 0 dB leaves it fixed. */
+	void setDynamics(FloatType decibels) noexcept { dynamicsRange.setTargetValue(juce::Decibels::decibelsToGain(decibels)); }
+
+	void setEnvelope(typename EnvelopeFollower<FloatType>::Detector detector, FloatType attackMilliseconds, FloatType releaseMilliseconds) noexcept
+	{
+		follower.setDetector(detector);
+		follower.setTimes(attackMilliseconds, releaseMilliseconds);
+	}
+
+	/** True while the envelope moves the drive, or is about to. */
+	bool isDynamic() const noexcept { return dynamicsRange.isSmoothing() || dynamicsRange.getTargetValue() != (FloatType)1; }
+
+	/** A level shared by every linked channel for the next process() call to follow, or nullptr to follow the band's own. */
+	void setLinkedLevel(const float* newLinkedLevel) noexcept { linkedLevel = newLinkedLevel; }
+
+	/**
+		Per base-rate sample drive multipliers and mix offsets for the next process()
+		call, or nullptr for none; they must stay valid until it returns.
+	*/
+	void setModulation(const float* newDriveModulation, const float* newMixModulation) noexcept
+	{
+		driveModulation = newDriveModulation;
+		mixModulation = newMixModulation;
+	}
+
+	void setCurve(WaveshaperCurve curve) noexcept
+	{
+		shaper.setCurve(curve);
+
+		for (auto& antiderivative : antiderivatives)
+			antiderivative.setCurve(curve);
+	}
+
+	/** Takes effect on the next process() call, or once a switch in progress is done, with a crossfade if it differs. */
+	void setOversampling(int numStages, typename Oversampler::FilterType filterType) noexcept
+	{
+		pendingStages = numStages;
+		pendingFilterType = filterType;
+	}
+
+	/** While switching, the larger of the two paths' latencies, since the other is delayed to match. */
+	double getLatencyInSamples() const noexcept
+	{
+		const auto latency = oversamplers[active].getLatencyInSamples();
+		return fadePosition < 0 ? latency : juce::jmax(latency, oversamplers[1 - active].getLatencyInSamples());
+	}
+
+	/** Moves the drive and mix ramps on by one base-rate block. */
+	void advance(int numSamples) noexcept
+	{
+		driveStart = driveGain.getCurrentValue();
+		mixStart = mix.getCurrentValue();
+		driveEnd = driveGain.skip(numSamples);
+		mixEnd = mix.skip(numSamples);
+		dynamicsStart = dynamicsRange.getCurrentValue();
+		dynamicsEnd = dynamicsRange.skip(numSamples);
+	}
+
+	void process(const juce::dsp::AudioBlock<Register>& band) noexcept
+	{
+		const auto followingEnvelope = dynamicsStart != (FloatType)1 || dynamicsEnd != (FloatType)1;
+		perSampleDrive = followingEnvelope || driveModulation != nullptr;
+
+		if (followingEnvelope && linkedLevel != nullptr)
+			follower.processLinked(linkedLevel, driveGains.getChannelPointer(0), band.getNumSamples(), dynamicsStart, dynamicsEnd);
+		else if (followingEnvelope)
+			follower.process(band.getChannelPointer(0), driveGains.getChannelPointer(0), band.getNumSamples(), dynamicsStart, dynamicsEnd);
+
+		if (driveModulation != nullptr)
+			applyDriveModulation(band.getNumSamples(), followingEnvelope);
+
+		const auto& current = oversamplers[active];
+
+		if (fadePosition < 0 && (current.getNumStages() != pendingStages || current.getFilterType() != pendingFilterType))
+			startSwitch();
+
+		const auto numSamples = band.getNumSamples();
+		storeHistory(inputHistory, inputWrite, band.getChannelPointer(0), numSamples);
+		historyFilled = juce::jmin(historyLength, historyFilled + numSamples);
+
+		if (fadePosition < 0)
+		{
+			render(active, band);
+			storeHistory(delayLine, delayWrite, band.getChannelPointer(0), numSamples);
+			return;
+		}
+
+		auto incoming = crossfadeData.getSubBlock(0, numSamples);
+		incoming.copyFrom(band);
+
+		render(active, band);
+		render(1 - active, incoming);
+
+		auto* out = band.getChannelPointer(0);
+		auto* in = incoming.getChannelPointer(0);
+		delay(alignment > 0 ? out : in, numSamples);
+
+		const auto fadeStep = (FloatType)1 / (FloatType)fadeLength;
+
+		for (size_t i = 0; i < numSamples; ++i)
+		{
+			const auto fade = juce::jmin((FloatType)1, (FloatType)(fadePosition + (int)i + 1) * fadeStep);
+			out[i] = out[i] + (in[i] - out[i]) * fade;
+		}
+
+		fadePosition += (int)numSamples;
+
+		if (fadePosition >= fadeLength)
+		{
+			active = 1 - active;
+			fadePosition = -1;
+		}
+	}
+
+private:
+	void applyDriveModulation(size_t numSamples, bool followingEnvelope) noexcept
+	{
+		auto* gains = driveGains.getChannelPointer(0);
+
+		if (followingEnvelope)
+		{
+			for (size_t i = 0; i < numSamples; ++i)
+				gains[i] *= Register::expand((FloatType)driveModulation[i]);
+
+			return;
+		}
+
+		for (size_t i = 0; i < numSamples; ++i)
+			gains[i] = Register::expand((FloatType)driveModulation[i]);
+	}
+
+	/** Sets up the other oversampler for the pending configuration and starts fading to it. */
+	void startSwitch() noexcept
+	{
+		const auto incoming = 1 - active;
+		auto& next = oversamplers[incoming];
+		next.setConfiguration(pendingStages, pendingFilterType);
+		next.reset();
+		antiderivatives[incoming].reset();
+
+		alignment = juce::jlimit(-(int)historyLength + 1, (int)historyLength - 1,
+			juce::roundToInt(next.getLatencyInSamples() - oversamplers[active].getLatencyInSamples()));
+
+		// Run the recent input through it, so it joins with its filters and ADAA state
+		// already settled. The ramps and per-sample values belong to the block about
+		// to be processed, so the priming holds them where that block starts.
+		const auto primeLength = juce::jmin(historyFilled, primeData.getNumSamples());
+		auto prime = primeData.getSubBlock(0, primeLength);
+		auto* primed = prime.getChannelPointer(0);
+		const auto* history = inputHistory.getChannelPointer(0);
+
+		for (size_t i = 0; i < primeLength; ++i)
+			primed[i] = history[(inputWrite + historyLength - primeLength + i) & (historyLength - 1)];
+
+		const auto saved = std::make_tuple(driveEnd, mixEnd, perSampleDrive, mixModulation);
+		driveEnd = driveStart;
+		mixEnd = mixStart;
+		perSampleDrive = false;
+		mixModulation = nullptr;
+
+		if (primeLength > 0)
+			render(incoming, prime);
+
+		std::tie(driveEnd, mixEnd, perSampleDrive, mixModulation) = saved;
+
+		// When the new path is the earlier one it is the one delayed, so the delay line
+		// starts from its primed output rather than from the old path's.
+		if (alignment < 0)
+		{
+			delayLine.clear();
+			storeHistory(delayLine, delayWrite, primed, primeLength);
+		}
+
+		fadePosition = 0;
+	}
+
+	/** Appends samples to one of the circular histories. */
+	static void storeHistory(const juce::dsp::AudioBlock<Register>& history, size_t& write, const Register* samples, size_t numSamples) noexcept
+	{
+		auto* data = history.getChannelPointer(0);
+
+		for (size_t i = numSamples > historyLength ? numSamples - historyLength : 0; i < numSamples; ++i)
+		{
+			data[write] = samples[i];
+			write = (write + 1) & (historyLength - 1);
+		}
+	}
+
+	/** Delays the earlier path by the latency difference, in place, through the delay line. */
+	void delay(Register* samples, size_t numSamples) noexcept
+	{
+		const auto amount = (size_t)std::abs(alignment);
+
+		if (amount == 0)
+			return;
+
+		auto* data = delayLine.getChannelPointer(0);
+
+		for (size_t i = 0; i < numSamples; ++i)
+		{
+			data[delayWrite] = samples[i];
+			samples[i] = data[(delayWrite + historyLength - amount) & (historyLength - 1)];
+			delayWrite = (delayWrite + 1) & (historyLength - 1);
+		}
+	}
+
+	void render(size_t index, const juce::dsp::AudioBlock<Register>& band) noexcept
+	{
+		auto& oversampler = oversamplers[index];
+		auto oversampled = oversampler.processUp(band);
+		blend(oversampled, (size_t)oversampler.getNumStages(), antiderivatives[index]);
+		oversampler.processDown(band);
+	}
+
+	void blend(const juce::dsp::AudioBlock<Register>& block, size_t numStages, AntiderivativeShaper<FloatType>& antiderivative) noexcept
+	{
+		if (antiderivative.getMode() != AntialiasingMode::Off)
+		{
+			blendWith(block, numStages, [&antiderivative](Register& dry, Register drive)
+			{
+				const auto wet = antiderivative.processSample(dry * drive);
+				dry = antiderivative.alignDry(dry);
+				return wet;
+			});
+
+			return;
+		}
+
+		shaper.process([&](const auto& shape)
+		{
+			blendWith(block, numStages, [&shape](Register& dry, Register drive) { return shape(dry * drive); });
+		});
+	}
+
+	/** wetFor(dry, drive) returns the shaped sample and may delay dry to match it. */
+	template <typename WetFunction>
+	void blendWith(const juce::dsp::AudioBlock<Register>& block, size_t numStages, WetFunction&& wetFor) const noexcept
+	{
+		if (mixModulation == nullptr)
+		{
+			blendWithMix(block, numStages, wetFor, [](size_t, FloatType wet) { return wet; });
+			return;
+		}
+
+		const auto* offsets = mixModulation;
+		blendWithMix(block, numStages, wetFor, [offsets, numStages](size_t i, FloatType wet)
+		{
+			return juce::jlimit((FloatType)0, (FloatType)1, wet + (FloatType)offsets[i >> numStages]);
+		});
+	}
+
+	/** mixAt(i, wet) gives the mix for oversampled sample i from the ramped one. */
+	template <typename WetFunction, typename MixFunction>
+	void blendWithMix(const juce::dsp::AudioBlock<Register>& block, size_t numStages, WetFunction& wetFor, MixFunction&& mixAt) const noexcept
+	{
+		if (!perSampleDrive)
+		{
+			blendSamples(block, wetFor, [](size_t) { return Register::expand((FloatType)1); }, mixAt);
+			return;
+		}
+
+		const auto* gains = driveGains.getChannelPointer(0);
+		blendSamples(block, wetFor, [gains, numStages](size_t i) { return gains[i >> numStages]; }, mixAt);
+	}
+
+	/** envelopeAt(i) gives the drive multiplier for oversampled sample i. */
+	template <typename WetFunction, typename EnvelopeFunction, typename MixFunction>
+	void blendSamples(const juce::dsp::AudioBlock<Register>& block, WetFunction& wetFor, EnvelopeFunction&& envelopeAt, MixFunction& mixAt) const noexcept
+	{
+		const auto numSamples = block.getNumSamples();
+		auto* samples = block.getChannelPointer(0);
+
+		if (driveStart == driveEnd && mixStart == mixEnd)
+		{
+			for (size_t i = 0; i < numSamples; ++i)
+			{
+				auto dry = samples[i];
+				const auto shaped = wetFor(dry, envelopeAt(i) * driveEnd);
+				samples[i] = dry + (shaped - dry) * mixAt(i, mixEnd);
+			}
+
+			return;
+		}
+
+		// Ramps are spread over however many samples the oversampled block has.
+		const auto driveStep = (driveEnd - driveStart) / (FloatType)numSamples;
+		const auto mixStep = (mixEnd - mixStart) / (FloatType)numSamples;
+
+		for (size_t i = 0; i < numSamples; ++i)
+		{
+			const auto drive = driveStart + driveStep * (FloatType)(i + 1);
+			const auto wet = mixAt(i, mixStart + mixStep * (FloatType)(i + 1));
+			auto dry = samples[i];
+			const auto shaped = wetFor(dry, envelopeAt(i) * drive);
+			samples[i] = dry + (shaped - dry) * wet;
+		}
+	}
+
+	juce::SmoothedValue<FloatType, juce::ValueSmoothingTypes::Multiplicative> driveGain{ (FloatType)1 };
+	juce::SmoothedValue<FloatType> mix{ (FloatType)1 };
+	juce::SmoothedValue<FloatType, juce::ValueSmoothingTypes::Multiplicative> dynamicsRange{ (FloatType)1 };
+	FloatType driveStart{ 1 }, driveEnd{ 1 }, mixStart{ 1 }, mixEnd{ 1 }, dynamicsStart{ 1 }, dynamicsEnd{ 1 };
+	Waveshaper<FloatType> shaper;
+
+	// One ADAA state per oversampler, so the incoming path never runs on state the outgoing one advanced.
+	std::array<AntiderivativeShaper<FloatType>, 2> antiderivatives;
+	std::array<Oversampler, 2> oversamplers;
+	size_t active = 0;
+	int pendingStages = 0;
+	typename Oversampler::FilterType pendingFilterType = Oversampler::FilterType::MinimumPhaseIIR;
+
+	// Switching: progress through the fade (-1 when not switching), and the latency
+	// difference of the new path over the old, in samples.
+	static constexpr double switchFadeSeconds = 0.01;
+	int fadeLength = 441, fadePosition = -1, alignment = 0;
+	juce::HeapBlock<char> crossfadeStorage;
+	juce::dsp::AudioBlock<Register> crossfadeData;
+
+	// The last historyLength input samples, to prime an incoming oversampler, and the
+	// output the alignment delay reads from. Both are circular.
+	static constexpr size_t historyLength = 256;
+	size_t historyFilled = 0, inputWrite = 0, delayWrite = 0;
+	juce::HeapBlock<char> inputHistoryStorage, delayLineStorage, primeStorage;
+	juce::dsp::AudioBlock<Register> inputHistory, delayLine, primeData;
+
+	// The envelope's multipliers, times the drive modulation when there is any.
+	EnvelopeFollower<FloatType> follower;
+	bool perSampleDrive = false;
+	juce::HeapBlock<char> driveGainStorage;
+	juce::dsp::AudioBlock<Register> driveGains;
+	const float* driveModulation = nullptr;
+	const float* mixModulation = nullptr;
+	const float* linkedLevel = nullptr;
+};
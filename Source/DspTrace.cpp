@@ -0,0 +1,172 @@
+/*
+  ==============================================================================
+
+	Per-block timing trace of the DSP stages, for finding which one blew a
+	deadline.
+
+  ==============================================================================
+*/
+
+#include "DspTrace.h"
+#include "BandWorkerPool.h"
+
+namespace DspTrace
+{
+	const char* getStageName(Stage stage) noexcept
+	{
+		switch (stage)
+		{
+		case Stage::ProcessBlock: return "processBlock";
+		case Stage::LowCut: return "LowCut";
+		case Stage::Peak: return "Peak";
+		case Stage::HighCut: return "HighCut";
+		case Stage::Crossover: return "Crossover";
+		case Stage::Band: return "Band";
+		case Stage::BandSum: return "Band sum";
+		}
+
+		return "";
+	}
+
+	double measureTicksPerSecond()
+	{
+	   #if JUCE_INTEL
+		const auto clockStart = std::chrono::steady_clock::now();
+		const auto ticksStart = now();
+		juce::Thread::sleep(50);
+		const auto ticksEnd = now();
+		const std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - clockStart;
+		return (double)(ticksEnd - ticksStart) / elapsed.count();
+	   #else
+		using Period = std::chrono::steady_clock::period;
+		return (double)Period::den / (double)Period::num;
+	   #endif
+	}
+
+	void Recorder::prepare(double newSampleRate)
+	{
+		sampleRate = newSampleRate;
+
+		if (events == nullptr)
+			events.allocate((size_t)capacity, true);
+	}
+
+	void ScopedEvent::begin(Stage stage, int index, int numSamples) noexcept
+	{
+		event.stage = stage;
+		event.index = (juce::int16)index;
+		event.numSamples = numSamples;
+		event.thread = (juce::uint8)BandWorkerPool::getCurrentWorkerIndex();
+		event.start = now();
+	}
+
+	//==============================================================================
+	Writer::Writer(Recorder& source, const juce::File& destination)
+		: juce::Thread("DSP trace writer"), recorder(source), file(destination)
+	{
+		chromeFormat = file.hasFileExtension("json");
+		startThread(juce::Thread::Priority::low);
+	}
+
+	Writer::~Writer()
+	{
+		stopThread(2000);
+	}
+
+	void Writer::run()
+	{
+		file.deleteFile();
+		stream = file.createOutputStream();
+
+		if (stream == nullptr)
+			return;
+
+		const auto ticksPerSecond = measureTicksPerSecond();
+		ticksPerMicrosecond = ticksPerSecond * 1.0e-6;
+
+		if (chromeFormat)
+		{
+			*stream << "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n";
+		}
+		else
+		{
+			stream->write("MBDT", 4);
+			stream->writeInt(1);
+			stream->writeDouble(ticksPerSecond);
+		}
+
+		auto drain = [this]
+		{
+			recorder.drain([this](const Event& event)
+			{
+				if (chromeFormat)
+					writeChromeEvent(event);
+				else
+					stream->write(&event, sizeof(event));
+			});
+		};
+
+		while (!threadShouldExit())
+		{
+			drain();
+			wait(20);
+		}
+
+		drain();
+
+		if (chromeFormat)
+			writeChromeTrailer();
+
+		stream->flush();
+		stream.reset();
+	}
+
+	void Writer::writeChromeEvent(const Event& event)
+	{
+		if (origin == 0)
+			origin = event.start;
+
+		const auto timestamp = (double)(juce::int64)(event.start - origin) / ticksPerMicrosecond;
+		const auto duration = (double)(event.end - event.start) / ticksPerMicrosecond;
+
+		juce::String name(getStageName(event.stage));
+
+		if (event.stage == Stage::Band)
+			name << " " << (event.index + 1);
+
+		juce::String line;
+		line << (firstEvent ? "" : ",\n")
+			<< "{\"name\":\"" << name << "\",\"cat\":\"dsp\",\"ph\":\"X\",\"pid\":1,\"tid\":" << (int)event.thread
+			<< ",\"ts\":" << juce::String(timestamp, 3) << ",\"dur\":" << juce::String(duration, 3)
+			<< ",\"args\":{\"block\":" << (int)event.block << ",\"samples\":" << event.numSamples << "}}";
+
+		// A block that took longer to compute than to play is a missed deadline.
+		if (event.stage == Stage::ProcessBlock && event.numSamples > 0)
+		{
+			const auto budget = event.numSamples / recorder.getSampleRate() * 1.0e6;
+
+			if (duration > budget)
+				line << ",\n{\"name\":\"Deadline miss\",\"cat\":\"dsp\",\"ph\":\"i\",\"s\":\"g\",\"pid\":1,\"tid\":0,\"ts\":"
+					<< juce::String(timestamp + duration, 3) << ",\"args\":{\"block\":" << (int)event.block
+					<< ",\"load\":" << juce::String(duration / budget, 2) << "}}";
+		}
+
+		*stream << line;
+		firstEvent = false;
+		numThreads = juce::jmax(numThreads, (int)event.thread + 1);
+	}
+
+	void Writer::writeChromeTrailer()
+	{
+		for (int thread = 0; thread < numThreads; ++thread)
+		{
+			const auto threadName = thread == 0 ? juce::String("Audio thread") : "Band worker " + juce::String(thread);
+
+			*stream << (firstEvent ? "" : ",\n") << "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":" << thread
+				<< ",\"args\":{\"name\":\"" << threadName << "\"}}";
+			firstEvent = false;
+		}
+
+		*stream << "\n],\"droppedEvents\":" << recorder.getNumDropped() << "}\n";
+	}
+}
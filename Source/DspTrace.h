@@ -0,0 +1,200 @@
+/*
+  ==============================================================================
+
+	Per-block timing trace of the DSP stages, for finding which one blew a
+	deadline.
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+
+#if JUCE_INTEL
+ #if JUCE_MSVC
+  #include <intrin.h>
+ #else
+  #include <x86intrin.h>
+ #endif
+#endif
+
+// Off by default; the MULTIBAND_DSP_TRACE CMake option (or the same
+// preprocessor definition in the Projucer) turns it on. When off, the trace
+// macros expand to nothing.
+#ifndef MULTIBAND_DSP_TRACE
+ #define MULTIBAND_DSP_TRACE 0
+#endif
+
+namespace DspTrace
+{
+	enum class Stage : juce::uint8
+	{
+		ProcessBlock,
+		LowCut,
+		Peak,
+		HighCut,
+		Crossover,
+		Band,
+		BandSum
+	};
+
+	const char* getStageName(Stage stage) noexcept;
+
+	constexpr bool isEnabled() noexcept { return MULTIBAND_DSP_TRACE != 0; }
+
+	/** Raw timestamp: the TSC on x86, steady_clock ticks elsewhere. */
+	inline juce::uint64 now() noexcept
+	{
+	   #if JUCE_INTEL
+		return (juce::uint64)__rdtsc();
+	   #else
+		return (juce::uint64)std::chrono::steady_clock::now().time_since_epoch().count();
+	   #endif
+	}
+
+	/** Rate of now(), measured against steady_clock; blocks for a moment. */
+	double measureTicksPerSecond();
+
+	struct Event
+	{
+		juce::uint64 start = 0, end = 0;
+		juce::uint32 block = 0;
+		juce::int32 numSamples = 0;
+		juce::int16 index = -1;
+		Stage stage = Stage::ProcessBlock;
+		juce::uint8 thread = 0;
+	};
+
+	//==============================================================================
+	/**
+		Single-producer ring of trace events for one processor instance. Only the
+		audio thread records; work done on other threads is timed into an Event
+		and recorded once it has joined. A full ring drops events rather than
+		waiting, and counts them.
+	*/
+	class Recorder
+	{
+	public:
+		static constexpr int capacity = 1 << 16;
+
+		Recorder() = default;
+
+		/** Allocates the ring; call before the first block. */
+		void prepare(double newSampleRate);
+
+		void beginBlock() noexcept { ++blockIndex; }
+
+		void record(Event event) noexcept
+		{
+			event.block = blockIndex;
+			const auto scope = fifo.write(1);
+
+			if (scope.blockSize1 + scope.blockSize2 == 0)
+			{
+				dropped.fetch_add(1, std::memory_order_relaxed);
+				return;
+			}
+
+			events[scope.blockSize1 > 0 ? scope.startIndex1 : scope.startIndex2] = event;
+		}
+
+		/** Hands every pending event to fn; for the draining thread only. */
+		template <typename Function>
+		void drain(Function&& fn)
+		{
+			const auto scope = fifo.read(fifo.getNumReady());
+
+			for (int i = 0; i < scope.blockSize1; ++i)
+				fn(events[scope.startIndex1 + i]);
+
+			for (int i = 0; i < scope.blockSize2; ++i)
+				fn(events[scope.startIndex2 + i]);
+		}
+
+		double getSampleRate() const noexcept { return sampleRate.load(); }
+		int getNumDropped() const noexcept { return dropped.load(std::memory_order_relaxed); }
+
+	private:
+		juce::AbstractFifo fifo{ capacity };
+		juce::HeapBlock<Event> events;
+		juce::uint32 blockIndex = 0;
+		std::atomic<double> sampleRate{ 44100.0 };
+		std::atomic<int> dropped{ 0 };
+
+		JUCE_DECLARE_NON_COPYABLE(Recorder)
+	};
+
+	//==============================================================================
+	/** Times its own lifetime into a Recorder, or into an Event to record later. */
+	class ScopedEvent
+	{
+	public:
+		ScopedEvent(Recorder& destination, Stage stage, int index = -1, int numSamples = 0) noexcept
+			: recorder(&destination)
+		{
+			begin(stage, index, numSamples);
+		}
+
+		ScopedEvent(Event& destination, Stage stage, int index = -1, int numSamples = 0) noexcept
+			: target(&destination)
+		{
+			begin(stage, index, numSamples);
+		}
+
+		~ScopedEvent()
+		{
+			event.end = now();
+
+			if (recorder != nullptr)
+				recorder->record(event);
+			else
+				*target = event;
+		}
+
+	private:
+		void begin(Stage stage, int index, int numSamples) noexcept;
+
+		Recorder* recorder = nullptr;
+		Event* target = nullptr;
+		Event event;
+
+		JUCE_DECLARE_NON_COPYABLE(ScopedEvent)
+	};
+
+	//==============================================================================
+	/**
+		Background thread that drains a Recorder to disk. A .json file gets the
+		Chrome trace format (chrome://tracing, Perfetto), with a "Deadline miss"
+		marker on every block that took longer than its own duration. Anything
+		else gets the compact binary log: the bytes "MBDT", a uint32 version, a
+		float64 tick rate and then the raw Event records.
+	*/
+	class Writer : private juce::Thread
+	{
+	public:
+		Writer(Recorder& source, const juce::File& destination);
+		~Writer() override;
+
+	private:
+		void run() override;
+		void writeChromeEvent(const Event& event);
+		void writeChromeTrailer();
+
+		Recorder& recorder;
+		juce::File file;
+		std::unique_ptr<juce::OutputStream> stream;
+		bool chromeFormat = true, firstEvent = true;
+		double ticksPerMicrosecond = 1.0;
+		juce::uint64 origin = 0;
+		int numThreads = 1;
+
+		JUCE_DECLARE_NON_COPYABLE(Writer)
+	};
+}
+
+#if MULTIBAND_DSP_TRACE
+ #define MULTIBAND_TRACE_SCOPE(destination, ...) const DspTrace::ScopedEvent JUCE_JOIN_MACRO(traceEvent, __LINE__)(destination, __VA_ARGS__)
+#else
+ #define MULTIBAND_TRACE_SCOPE(destination, ...)
+#endif
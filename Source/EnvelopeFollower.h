@@ -0,0 +1,179 @@
+/*
+  ==============================================================================
+
+	Envelope detector that turns a band's level into a drive multiplier.
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+
+//==============================================================================
+/**
+	Peak or RMS envelope of SIMD-interleaved samples, one envelope per lane, so
+	every channel of a band is followed in the same pass.
+
+	Attack or release is picked per lane with a compare mask rather than a branch.
+	Linked, every lane follows one level instead: accumulateLinked() gathers it
+	from any number of blocks' active lanes, and processLinked() follows it.
+	process() maps the envelope to a drive multiplier,
+		1 + (range - 1) * min(envelope, 1),
+	so a full-scale band has its drive moved by exactly the range and a silent one
+	is left alone.
+*/
+template <typename FloatType>
+class EnvelopeFollower
+{
+public:
+	using Register = juce::dsp::SIMDRegister<FloatType>;
+
+	static constexpr size_t numLanes = Register::size();
+
+	enum class Detector
+	{
+		Peak,
+		Rms
+	};
+
+	/** Whether the lanes follow their own levels, or the max or mean of every active lane. */
+	enum class Link
+	{
+		Unlinked,
+		Max,
+		Mean
+	};
+
+	/**
+		Adds one block's active lanes to a linked level, in the detector's own terms:
+		magnitudes for peak, squares for RMS. The first block overwrites the level.
+	*/
+	static void accumulateLinked(const Register* input, size_t numActiveLanes, float* level, size_t numSamples,
+		Link link, Detector detector, bool first) noexcept
+	{
+		const auto* values = reinterpret_cast<const FloatType*>(input);
+
+		for (size_t i = 0; i < numSamples; ++i)
+		{
+			auto combined = first ? 0.f : level[i];
+
+			for (size_t lane = 0; lane < numActiveLanes; ++lane)
+			{
+				const auto value = (float)values[i * numLanes + lane];
+				const auto measure = detector == Detector::Rms ? value * value : std::abs(value);
+				combined = link == Link::Max ? juce::jmax(combined, measure) : combined + measure;
+			}
+
+			level[i] = combined;
+		}
+	}
+
+	/** Turns an accumulated level back into a signal the detector can follow. */
+	static void finishLinked(float* level, size_t numSamples, Link link, Detector detector, size_t totalLanes) noexcept
+	{
+		const auto scale = link == Link::Mean ? 1.f / (float)juce::jmax((size_t)1, totalLanes) : 1.f;
+
+		for (size_t i = 0; i < numSamples; ++i)
+			level[i] = detector == Detector::Rms ? std::sqrt(level[i] * scale) : level[i] * scale;
+	}
+
+	void prepare(double newSampleRate) noexcept
+	{
+		sampleRate = newSampleRate;
+		updateCoefficients();
+		reset();
+	}
+
+	void reset() noexcept { envelope = Register::expand((FloatType)0); }
+
+	void setDetector(Detector newDetector) noexcept { detector = newDetector; }
+
+	void setTimes(FloatType newAttackMilliseconds, FloatType newReleaseMilliseconds) noexcept
+	{
+		if (newAttackMilliseconds == attackMilliseconds && newReleaseMilliseconds == releaseMilliseconds)
+			return;
+
+		attackMilliseconds = newAttackMilliseconds;
+		releaseMilliseconds = newReleaseMilliseconds;
+		updateCoefficients();
+	}
+
+	/** Writes one drive multiplier per input sample; the range ramps linearly across the block. */
+	void process(const Register* input, Register* gains, size_t numSamples, FloatType rangeStart, FloatType rangeEnd) noexcept
+	{
+		const auto attack = Register::expand(attackCoefficient);
+		const auto release = Register::expand(releaseCoefficient);
+		const auto one = Register::expand((FloatType)1);
+
+		const auto depthStep = (rangeEnd - rangeStart) / (FloatType)numSamples;
+		auto depth = rangeStart - (FloatType)1;
+
+		if (detector == Detector::Peak)
+		{
+			for (size_t i = 0; i < numSamples; ++i)
+			{
+				track(Register::abs(input[i]), attack, release);
+				depth += depthStep;
+				gains[i] = one + Register::min(envelope, one) * depth;
+			}
+
+			return;
+		}
+
+		for (size_t i = 0; i < numSamples; ++i)
+		{
+			track(input[i] * input[i], attack, release);
+			gains[i] = envelope;
+		}
+
+		// The square root has no SIMDRegister form, but over the flat lanes this loop vectorises.
+		auto* values = reinterpret_cast<FloatType*>(gains);
+
+		for (size_t i = 0; i < numSamples; ++i)
+		{
+			depth += depthStep;
+
+			for (size_t lane = 0; lane < numLanes; ++lane)
+			{
+				auto& value = values[i * numLanes + lane];
+				value = (FloatType)1 + juce::jmin(std::sqrt(value), (FloatType)1) * depth;
+			}
+		}
+	}
+
+	/** As process(), following one linked level in every lane. gains may be the buffer the level is expanded into. */
+	void processLinked(const float* level, Register* gains, size_t numSamples, FloatType rangeStart, FloatType rangeEnd) noexcept
+	{
+		for (size_t i = 0; i < numSamples; ++i)
+			gains[i] = Register::expand((FloatType)level[i]);
+
+		process(gains, gains, numSamples, rangeStart, rangeEnd);
+	}
+
+private:
+	void track(Register level, Register attack, Register release) noexcept
+	{
+		const auto rising = Register::greaterThan(level, envelope);
+		const auto coefficient = release + ((attack - release) & rising);
+		envelope += (level - envelope) * coefficient;
+	}
+
+	void updateCoefficients() noexcept
+	{
+		// One-pole smoothing that covers 1 - 1/e of a step in the given time.
+		auto coefficientFor = [this](FloatType milliseconds)
+		{
+			return (FloatType)(1.0 - std::exp(-1000.0 / (juce::jmax((FloatType)0.01, milliseconds) * sampleRate)));
+		};
+
+		attackCoefficient = coefficientFor(attackMilliseconds);
+		releaseCoefficient = coefficientFor(releaseMilliseconds);
+	}
+
+	double sampleRate = 44100.0;
+	Detector detector = Detector::Peak;
+	FloatType attackMilliseconds{ 5 }, releaseMilliseconds{ 100 };
+	FloatType attackCoefficient{ 0 }, releaseCoefficient{ 0 };
+	Register envelope = Register::expand((FloatType)0);
+};
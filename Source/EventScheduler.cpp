@@ -0,0 +1,119 @@
+/*
+  ==============================================================================
+
+	Sample-accurate parameter events: MIDI controllers mapped to parameters, and
+	the split of each block at the samples they arrive on.
+
+  ==============================================================================
+*/
+
+#include "EventScheduler.h"
+
+const juce::Identifier EventScheduler::stateType("Controllers");
+
+EventScheduler::EventScheduler(juce::AudioProcessorValueTreeState& apvts)
+{
+	forEachParameter([this, &apvts](const ParameterDescriptor& descriptor, int index)
+	{
+		auto* parameter = apvts.getParameter(getParameterID(descriptor.param, index));
+		jassert(parameter != nullptr);
+		parameters[(size_t)getParameterSlot(descriptor.param, index)] = parameter;
+	});
+
+	for (auto& slot : controllerSlots)
+		slot = -1;
+
+	for (int band = 0; band < maxBands; ++band)
+		setMapping(20 + band, Param::BandDrive, band);
+}
+
+void EventScheduler::setMapping(int controller, Param param, int index) noexcept
+{
+	if (juce::isPositiveAndBelow(controller, numControllers))
+		controllerSlots[(size_t)controller] = getParameterSlot(param, index);
+}
+
+void EventScheduler::clearMapping(int controller) noexcept
+{
+	if (juce::isPositiveAndBelow(controller, numControllers))
+		controllerSlots[(size_t)controller] = -1;
+}
+
+juce::ValueTree EventScheduler::getState() const
+{
+	juce::ValueTree state(stateType);
+
+	for (int controller = 0; controller < numControllers; ++controller)
+	{
+		const auto slot = controllerSlots[(size_t)controller].load();
+
+		if (slot < 0)
+			continue;
+
+		juce::ValueTree mapping("Mapping");
+		mapping.setProperty("Controller", controller, nullptr);
+		mapping.setProperty("Parameter", parameters[(size_t)slot]->getParameterID(), nullptr);
+		state.appendChild(mapping, nullptr);
+	}
+
+	return state;
+}
+
+void EventScheduler::setState(const juce::ValueTree& state)
+{
+	// Sessions from before controllers could be mapped keep the default mapping.
+	if (!state.isValid())
+		return;
+
+	for (auto& slot : controllerSlots)
+		slot = -1;
+
+	for (int i = 0; i < state.getNumChildren(); ++i)
+	{
+		const auto mapping = state.getChild(i);
+		const auto controller = (int)mapping.getProperty("Controller", -1);
+		const auto id = mapping.getProperty("Parameter").toString();
+
+		for (size_t slot = 0; slot < parameters.size(); ++slot)
+			if (parameters[slot]->getParameterID() == id && juce::isPositiveAndBelow(controller, numControllers))
+				controllerSlots[(size_t)controller] = (int)slot;
+	}
+}
+
+void EventScheduler::apply(int slot, int controllerValue, CoefficientEngine& engine) noexcept
+{
+	const auto& range = parameters[(size_t)slot]->getNormalisableRange();
+	const auto value = range.snapToLegalValue(range.convertFrom0to1((float)controllerValue / 127.f));
+
+	engine.setControllerValue(slot, value);
+
+	latestValues[(size_t)slot].store(value, std::memory_order_relaxed);
+	appliedCount[(size_t)slot].fetch_add(1, std::memory_order_release);
+}
+
+void EventScheduler::releaseSynced(CoefficientEngine& engine) noexcept
+{
+	// Once the timer has passed the last value on, the parameter holds it and the override can go.
+	for (int slot = 0; slot < numParameterSlots; ++slot)
+		if (engine.isControlled(slot)
+			&& syncedCount[(size_t)slot].load(std::memory_order_acquire) == appliedCount[(size_t)slot].load(std::memory_order_relaxed))
+			engine.releaseController(slot);
+}
+
+void EventScheduler::syncParameters()
+{
+	for (size_t slot = 0; slot < parameters.size(); ++slot)
+	{
+		const auto count = appliedCount[slot].load(std::memory_order_acquire);
+
+		if (count == syncedCount[slot].load(std::memory_order_relaxed))
+			continue;
+
+		auto* parameter = parameters[slot];
+		parameter->beginChangeGesture();
+		parameter->setValueNotifyingHost(parameter->convertTo0to1(latestValues[slot].load(std::memory_order_relaxed)));
+		parameter->endChangeGesture();
+
+		syncedCount[slot].store(count, std::memory_order_release);
+	}
+}
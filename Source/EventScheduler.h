@@ -0,0 +1,109 @@
+/*
+  ==============================================================================
+
+	Sample-accurate parameter events: MIDI controllers mapped to parameters, and
+	the split of each block at the samples they arrive on.
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+#include "ParameterRegistry.h"
+#include "CoefficientEngine.h"
+
+//==============================================================================
+/**
+	Turns mapped MIDI controller messages into parameter changes on the sample
+	they arrive on.
+
+	The audio thread hands each value straight to the CoefficientEngine as a
+	controller override and splits the block there, so everything after it is
+	processed with the new settings. No segment is shorter than
+	minimumSegmentSamples, unless the whole block is: an event closer than that to
+	the start of the segment it falls in, or to the end of the block, is applied
+	at the start of that segment instead. However dense the controller stream, a
+	block is never cut into more than numSamples / minimumSegmentSamples pieces.
+
+	The parameters, and the host, follow on the message thread: the processor's
+	timer calls syncParameters(), and the engine's override is dropped once its
+	parameter has caught up.
+
+	Host automation reaches the processor with no sample offset, so it still takes
+	effect at the start of the segment it arrives in.
+*/
+class EventScheduler
+{
+public:
+	static constexpr int minimumSegmentSamples = 32;
+	static constexpr int numControllers = 128;
+
+	/** Maps CC 20 to 25 to the band drives, which are otherwise unassigned controller numbers. */
+	explicit EventScheduler(juce::AudioProcessorValueTreeState& apvts);
+
+	/** Routes a controller number to a parameter; safe to call while audio is running. */
+	void setMapping(int controller, Param param, int index = 0) noexcept;
+	void clearMapping(int controller) noexcept;
+
+	/** The mapping, as stored in the plug-in state. */
+	static const juce::Identifier stateType;
+	juce::ValueTree getState() const;
+	void setState(const juce::ValueTree& state);
+
+	/**
+		Audio thread. Calls processSegment(start, length) for consecutive segments
+		covering numSamples, giving each mapped controller event to the engine
+		before the segment it lands in.
+	*/
+	template <typename ProcessSegment>
+	void process(const juce::MidiBuffer& midiMessages, int numSamples, CoefficientEngine& engine, ProcessSegment&& processSegment)
+	{
+		releaseSynced(engine);
+		auto start = 0;
+
+		for (const auto metadata : midiMessages)
+		{
+			const auto message = metadata.getMessage();
+
+			if (!message.isController())
+				continue;
+
+			const auto slot = controllerSlots[(size_t)message.getControllerNumber()].load(std::memory_order_relaxed);
+
+			if (slot < 0)
+				continue;
+
+			const auto position = metadata.samplePosition;
+
+			if (position >= start + minimumSegmentSamples && position <= numSamples - minimumSegmentSamples)
+			{
+				processSegment(start, position - start);
+				start = position;
+			}
+
+			apply(slot, message.getControllerValue(), engine);
+		}
+
+		processSegment(start, numSamples - start);
+	}
+
+	/** Message thread: moves the parameters to the values controllers have set, telling the host. */
+	void syncParameters();
+
+private:
+	void apply(int slot, int controllerValue, CoefficientEngine& engine) noexcept;
+	void releaseSynced(CoefficientEngine& engine) noexcept;
+
+	std::array<juce::RangedAudioParameter*, (size_t)numParameterSlots> parameters{};
+
+	// The parameter slot each controller drives, or -1.
+	std::array<std::atomic<int>, numControllers> controllerSlots;
+
+	// Per slot: the latest controller value, and how many of them the audio thread
+	// has applied and the timer has passed on to the parameter.
+	std::array<std::atomic<float>, (size_t)numParameterSlots> latestValues{};
+	std::array<std::atomic<juce::uint32>, (size_t)numParameterSlots> appliedCount{}, syncedCount{};
+
+	JUCE_DECLARE_NON_COPYABLE(EventScheduler)
+};
@@ -0,0 +1,285 @@
+/*
+  ==============================================================================
+
+	Linear-phase band splitter: FIR crossover kernels applied with uniformly
+	partitioned FFT convolution.
+
+  ==============================================================================
+*/
+
+#include "LinearPhaseCrossover.h"
+
+class LinearPhaseKernels::DesignThread : public juce::Thread
+{
+public:
+	explicit DesignThread(LinearPhaseKernels& owner)
+		: juce::Thread("Crossover kernel design"), kernels(owner)
+	{
+	}
+
+	void run() override
+	{
+		// Polls rather than being woken, since request() and update() run on the audio
+		// thread and signalling a WaitableEvent takes its lock. Checking is two atomic loads.
+		while (!threadShouldExit())
+		{
+			kernels.designPending();
+			wait(pollMilliseconds);
+		}
+	}
+
+private:
+	static constexpr int pollMilliseconds = 20;
+
+
+	LinearPhaseKernels& kernels;
+};
+
+//==============================================================================
+LinearPhaseKernels::LinearPhaseKernels()
+{
+	for (size_t i = 0; i < ffts.size(); ++i)
+		ffts[i] = std::make_unique<juce::dsp::FFT>(minCrossoverPartitionOrder + (int)i + 1);
+
+	const ChainSettings defaults;
+	lastRequest.numBands = defaults.numBands;
+	lastRequest.partitionOrder = defaults.crossoverPartitionOrder;
+	lastRequest.frequencies = defaults.crossoverFreqs;
+
+	for (size_t i = 0; i < requestedFrequencies.size(); ++i)
+		requestedFrequencies[i] = defaults.crossoverFreqs[i];
+}
+
+LinearPhaseKernels::~LinearPhaseKernels()
+{
+	release();
+}
+
+int LinearPhaseKernels::getNumTaps(double sampleRate) noexcept
+{
+	// About 85 ms of kernel, which resolves a crossover a few tens of Hz wide at the bottom.
+	return juce::nextPowerOfTwo(juce::roundToInt(sampleRate / 12.0)) - 1;
+}
+
+size_t LinearPhaseKernels::getMaxSpectrumSize(double sampleRate) noexcept
+{
+	const auto taps = getNumTaps(sampleRate);
+	size_t size = 0;
+
+	for (int order = minCrossoverPartitionOrder; order <= maxCrossoverPartitionOrder; ++order)
+	{
+		const auto partitionSize = 1 << order;
+		size = juce::jmax(size, (size_t)((taps + partitionSize - 1) / partitionSize) * (size_t)(partitionSize + 1));
+	}
+
+	return size;
+}
+
+void LinearPhaseKernels::prepare(double newSampleRate)
+{
+	release();
+
+	sampleRate = newSampleRate;
+	numTaps = getNumTaps(sampleRate);
+
+	// Blackman: sidelobes below -70 dB, so the bands leak little into each other.
+	window.resize((size_t)numTaps);
+
+	for (int i = 0; i < numTaps; ++i)
+	{
+		const auto phase = juce::MathConstants<double>::twoPi * i / (numTaps - 1);
+		window[(size_t)i] = 0.42 - 0.5 * std::cos(phase) + 0.08 * std::cos(2.0 * phase);
+	}
+
+	const auto spectrumSize = getMaxSpectrumSize(sampleRate) * (size_t)maxBands;
+
+	for (auto& set : sets)
+		set.spectra.allocate(spectrumSize, true);
+
+	current = 0;
+	retiring = -1;
+	published = -1;
+	released = -1;
+	freeSets = 0b110;
+
+	design(sets[0], readRequest());
+	designedGeneration = requestGeneration.load();
+
+	thread = std::make_unique<DesignThread>(*this);
+	thread->startThread(juce::Thread::Priority::low);
+}
+
+void LinearPhaseKernels::release()
+{
+	if (thread != nullptr)
+	{
+		thread->stopThread(1000);
+		thread.reset();
+	}
+}
+
+void LinearPhaseKernels::request(int numBands, const std::array<float, maxBands - 1>& frequencies, int partitionOrder) noexcept
+{
+	if (numBands == lastRequest.numBands && partitionOrder == lastRequest.partitionOrder && frequencies == lastRequest.frequencies)
+		return;
+
+	lastRequest.numBands = numBands;
+	lastRequest.partitionOrder = partitionOrder;
+	lastRequest.frequencies = frequencies;
+
+	requestedBands.store(numBands, std::memory_order_relaxed);
+	requestedPartitionOrder.store(partitionOrder, std::memory_order_relaxed);
+
+	for (size_t i = 0; i < frequencies.size(); ++i)
+		requestedFrequencies[i].store(frequencies[i], std::memory_order_relaxed);
+
+	requestGeneration.fetch_add(1, std::memory_order_release);
+}
+
+bool LinearPhaseKernels::update(int numSamples) noexcept
+{
+	// A convolver only notices a new set at its next partition, so the old one is
+	// kept until even the largest partition has gone by.
+	if (retiring >= 0)
+	{
+		retiringSamples += numSamples;
+
+		if (retiringSamples < maxPartitionSize)
+			return false;
+
+		auto empty = -1;
+
+		if (!released.compare_exchange_strong(empty, retiring, std::memory_order_release))
+			return false;
+
+		// A request that came in while every set was taken is designed on the next poll.
+		retiring = -1;
+	}
+
+	const auto next = published.exchange(-1, std::memory_order_acquire);
+
+	if (next < 0)
+		return false;
+
+	retiring = current;
+	retiringSamples = 0;
+	current = next;
+	return true;
+}
+
+LinearPhaseKernels::Request LinearPhaseKernels::readRequest() const noexcept
+{
+	Request request;
+	request.numBands = requestedBands.load(std::memory_order_relaxed);
+	request.partitionOrder = requestedPartitionOrder.load(std::memory_order_relaxed);
+
+	for (size_t i = 0; i < request.frequencies.size(); ++i)
+		request.frequencies[i] = requestedFrequencies[i].load(std::memory_order_relaxed);
+
+	return request;
+}
+
+void LinearPhaseKernels::designPending()
+{
+	const auto returned = released.exchange(-1, std::memory_order_acquire);
+
+	if (returned >= 0)
+		freeSets |= 1 << returned;
+
+	const auto generation = requestGeneration.load(std::memory_order_acquire);
+
+	if (generation == designedGeneration || freeSets == 0)
+		return;
+
+	const auto request = readRequest();
+
+	// Changed while it was being read: take it next time round instead.
+	if (requestGeneration.load(std::memory_order_acquire) != generation)
+		return;
+
+	const auto slot = juce::findHighestSetBit((juce::uint32)freeSets);
+	design(sets[(size_t)slot], request);
+	freeSets &= ~(1 << slot);
+	designedGeneration = generation;
+
+	// A set the audio thread never picked up is ours again.
+	const auto unclaimed = published.exchange(slot, std::memory_order_acq_rel);
+
+	if (unclaimed >= 0)
+		freeSets |= 1 << unclaimed;
+}
+
+void LinearPhaseKernels::design(KernelSet& set, const Request& request) const
+{
+	const auto partitionOrder = juce::jlimit(minCrossoverPartitionOrder, maxCrossoverPartitionOrder, request.partitionOrder);
+
+	set.partitionSize = 1 << partitionOrder;
+	set.numPartitions = (numTaps + set.partitionSize - 1) / set.partitionSize;
+	set.numBands = juce::jlimit(2, maxBands, request.numBands);
+	set.fft = ffts[(size_t)(partitionOrder - minCrossoverPartitionOrder)].get();
+
+	const auto partitionSize = (size_t)set.partitionSize;
+	const auto numBins = (size_t)set.getNumBins();
+
+	std::vector<double> below((size_t)numTaps, 0.0), above((size_t)numTaps);
+	std::vector<float> time(partitionSize * 4);
+	double previousFrequency = 0.0;
+
+	for (int band = 0; band < set.numBands; ++band)
+	{
+		// Crossover frequencies are clamped the way MultibandCrossover does it; the
+		// top band is whatever the last lowpass leaves of a unit impulse.
+		if (band < set.numBands - 1)
+		{
+			const auto frequency = juce::jlimit(10.0, sampleRate * 0.45, juce::jmax((double)request.frequencies[(size_t)band], previousFrequency));
+			makeLowPass(above, frequency);
+			previousFrequency = frequency;
+		}
+		else
+		{
+			std::fill(above.begin(), above.end(), 0.0);
+			above[(size_t)(numTaps - 1) / 2] = 1.0;
+		}
+
+		for (int partition = 0; partition < set.numPartitions; ++partition)
+		{
+			std::fill(time.begin(), time.end(), 0.f);
+
+			for (size_t i = 0; i < partitionSize; ++i)
+			{
+				const auto tap = (size_t)partition * partitionSize + i;
+
+				if (tap < (size_t)numTaps)
+					time[i] = (float)(above[tap] - below[tap]);
+			}
+
+			set.fft->performRealOnlyForwardTransform(time.data(), true);
+
+			const auto* spectrum = reinterpret_cast<const Complex*>(time.data());
+			std::copy(spectrum, spectrum + numBins, set.getPartition(band, partition));
+		}
+
+		std::swap(below, above);
+	}
+}
+
+void LinearPhaseKernels::makeLowPass(std::vector<double>& taps, double frequency) const
+{
+	const auto cutoff = frequency / sampleRate;
+	const auto centre = (numTaps - 1) / 2;
+	double sum = 0.0;
+
+	for (int i = 0; i < numTaps; ++i)
+	{
+		const auto x = (double)(i - centre);
+		const auto sinc = i == centre ? 2.0 * cutoff
+			: std::sin(juce::MathConstants<double>::twoPi * cutoff * x) / (juce::MathConstants<double>::pi * x);
+
+		taps[(size_t)i] = sinc * window[(size_t)i];
+		sum += taps[(size_t)i];
+	}
+
+	// Unity at DC, so every band's passband sits at 0 dB.
+	for (auto& tap : taps)
+		tap /= sum;
+}
@@ -0,0 +1,336 @@
+/*
+  ==============================================================================
+
+	Linear-phase band splitter: FIR crossover kernels applied with uniformly
+	partitioned FFT convolution.
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+#include <complex>
+#include "ChainSettings.h"
+
+//==============================================================================
+/**
+	The FIR kernels of every band of the linear-phase crossover, transformed and
+	split into partitions of the requested size.
+
+	Each band's kernel is the difference of windowed-sinc lowpasses at the
+	crossovers either side of it, so the bands sum back to a pure delay of
+	(numTaps - 1) / 2 samples.
+
+	Kernels are designed on a background thread, which checks every 20 ms for
+	something to design. The audio thread calls request() with the settings it
+	wants, which only bumps a generation when they changed, and update() once
+	per block, which swaps in the newest finished set; neither signals the thread. Three sets are allocated in prepare() and
+	passed between the two threads through atomics, so neither ever waits, and
+	the set being faded out is left alone until every convolver has moved off it.
+*/
+class LinearPhaseKernels
+{
+public:
+	using Complex = std::complex<float>;
+
+	static constexpr int maxPartitionSize = 1 << maxCrossoverPartitionOrder;
+
+	struct KernelSet
+	{
+		int partitionSize = 0, numPartitions = 0, numBands = 0;
+		const juce::dsp::FFT* fft = nullptr;
+		juce::HeapBlock<Complex> spectra;
+
+		/** Bins of a 2 * partitionSize point real FFT. */
+		int getNumBins() const noexcept { return partitionSize + 1; }
+
+		Complex* getPartition(int band, int partition) const noexcept
+		{
+			return spectra + ((size_t)band * (size_t)numPartitions + (size_t)partition) * (size_t)getNumBins();
+		}
+	};
+
+	LinearPhaseKernels();
+	~LinearPhaseKernels();
+
+	/** Kernel length at a sample rate; always odd, so the delay is a whole number of samples. */
+	static int getNumTaps(double sampleRate) noexcept;
+
+	/** Bins per band per lane for the partition size that needs the most of them. */
+	static size_t getMaxSpectrumSize(double sampleRate) noexcept;
+
+	/** Designs the last request straight away and starts the design thread. */
+	void prepare(double newSampleRate);
+	void release();
+
+	/** Audio thread: asks for kernels for these settings; wait-free, and does nothing if they haven't changed. */
+	void request(int numBands, const std::array<float, maxBands - 1>& frequencies, int partitionOrder) noexcept;
+
+	/** Audio thread, once per block: swaps in the newest finished set. Returns true if it did. */
+	bool update(int numSamples) noexcept;
+
+	/** Audio thread: the set the convolvers should use for this block. */
+	const KernelSet& getCurrent() const noexcept { return sets[(size_t)current]; }
+
+	/** The FIR's delay plus one partition of buffering. */
+	int getLatencyInSamples() const noexcept { return (numTaps - 1) / 2 + getCurrent().partitionSize; }
+
+private:
+	class DesignThread;
+
+	struct Request
+	{
+		int numBands = 0, partitionOrder = 0;
+		std::array<float, maxBands - 1> frequencies{};
+	};
+
+	Request readRequest() const noexcept;
+	void designPending();
+	void design(KernelSet& set, const Request& request) const;
+	void makeLowPass(std::vector<double>& taps, double frequency) const;
+
+	double sampleRate = 44100.0;
+	int numTaps = 0;
+	std::vector<double> window;
+	std::array<std::unique_ptr<juce::dsp::FFT>, maxCrossoverPartitionOrder - minCrossoverPartitionOrder + 1> ffts;
+
+	std::array<KernelSet, 3> sets;
+
+	// Audio thread.
+	int current = 0, retiring = -1, retiringSamples = 0;
+	Request lastRequest;
+
+	// Design thread.
+	int freeSets = 0;
+	juce::uint32 designedGeneration = 0;
+
+	std::atomic<int> published{ -1 }, released{ -1 };
+	std::atomic<int> requestedBands{ 3 }, requestedPartitionOrder{ 9 };
+	std::array<std::atomic<float>, maxBands - 1> requestedFrequencies{};
+	std::atomic<juce::uint32> requestGeneration{ 0 };
+
+	std::unique_ptr<DesignThread> thread;
+
+	JUCE_DECLARE_NON_COPYABLE(LinearPhaseKernels)
+};
+
+//==============================================================================
+/**
+	Splits a block of SIMD-interleaved samples into bands with the kernels of a
+	LinearPhaseKernels::KernelSet, as a drop-in for MultibandCrossover.
+
+	Uniformly partitioned overlap-save: input is collected a partition at a time,
+	transformed once per lane into a frequency-domain delay line shared by every
+	band, and each band is one multiply-accumulate over the partitions and one
+	inverse FFT. Output trails the input by one partition on top of the kernel
+	delay. When the kernels change, the next partition is computed with both the
+	old and new set and crossfaded; a different partition size starts again from
+	silence instead.
+
+	The convolution runs in float whatever FloatType is, since that is all
+	juce::dsp::FFT offers.
+*/
+template <typename FloatType>
+class LinearPhaseCrossover
+{
+public:
+	using Register = juce::dsp::SIMDRegister<FloatType>;
+	using KernelSet = LinearPhaseKernels::KernelSet;
+	using Complex = LinearPhaseKernels::Complex;
+
+	static constexpr size_t numLanes = Register::size();
+
+	void prepare(double sampleRate, int maximumBlockSize)
+	{
+		constexpr auto maxPartitionSize = (size_t)LinearPhaseKernels::maxPartitionSize;
+
+		bands = juce::dsp::AudioBlock<Register>(bandData, (size_t)maxBands, (size_t)maximumBlockSize);
+		input = juce::dsp::AudioBlock<Register>(inputData, 1, maxPartitionSize * 2);
+		outputs = juce::dsp::AudioBlock<Register>(outputData, (size_t)maxBands, maxPartitionSize);
+
+		spectrumSize = LinearPhaseKernels::getMaxSpectrumSize(sampleRate);
+		history.allocate(spectrumSize * numLanes, true);
+		scratch.allocate(maxPartitionSize * 4, true);
+		fadeScratch.allocate(maxPartitionSize * 4, true);
+
+		bands.clear();
+		reset();
+	}
+
+	void reset() noexcept
+	{
+		input.clear();
+		outputs.clear();
+		std::fill(history.get(), history.get() + spectrumSize * numLanes, Complex());
+		fill = 0;
+		newestPartition = 0;
+		stepBands = 0;
+		kernels = previousKernels = nullptr;
+	}
+
+	void split(const juce::dsp::AudioBlock<Register>& block, const KernelSet& newKernels) noexcept
+	{
+		if (&newKernels != kernels)
+		{
+			if (kernels != nullptr && newKernels.partitionSize == kernels->partitionSize)
+				previousKernels = kernels;
+			else
+				reset();
+
+			kernels = &newKernels;
+		}
+
+		numBands = juce::jmax(stepBands, kernels->numBands, previousKernels != nullptr ? previousKernels->numBands : 0);
+
+		const auto numSamples = block.getNumSamples();
+		const auto partitionSize = (size_t)kernels->partitionSize;
+		jassert(numSamples <= bands.getNumSamples());
+
+		auto* in = block.getChannelPointer(0);
+		auto* pending = input.getChannelPointer(0) + partitionSize;
+
+		for (size_t position = 0; position < numSamples;)
+		{
+			const auto numToCopy = juce::jmin(partitionSize - fill, numSamples - position);
+			std::copy(in + position, in + position + numToCopy, pending + fill);
+
+			for (size_t band = 0; band < (size_t)numBands; ++band)
+			{
+				auto* source = outputs.getChannelPointer(band) + fill;
+				std::copy(source, source + numToCopy, bands.getChannelPointer(band) + position);
+			}
+
+			fill += numToCopy;
+			position += numToCopy;
+
+			if (fill == partitionSize)
+			{
+				processPartition();
+				fill = 0;
+			}
+		}
+	}
+
+	/** The bands written by the last split(); may briefly exceed the kernels' count while fading between sets. */
+	int getNumBands() const noexcept { return numBands; }
+
+	juce::dsp::AudioBlock<Register> getBand(int band, size_t numSamples) const noexcept
+	{
+		return bands.getSingleChannelBlock((size_t)band).getSubBlock(0, numSamples);
+	}
+
+private:
+	void processPartition() noexcept
+	{
+		const auto& set = *kernels;
+		const auto partitionSize = (size_t)set.partitionSize;
+		const auto numPartitions = (size_t)set.numPartitions;
+		const auto numBins = (size_t)set.getNumBins();
+
+		// The delay line runs backwards, so partition p of the kernel meets slot newestPartition + p.
+		newestPartition = (newestPartition == 0 ? numPartitions : newestPartition) - 1;
+
+		auto* time = scratch.get();
+		const auto* samples = reinterpret_cast<const FloatType*>(input.getChannelPointer(0));
+
+		for (size_t lane = 0; lane < numLanes; ++lane)
+		{
+			for (size_t i = 0; i < partitionSize * 2; ++i)
+				time[i] = (float)samples[i * numLanes + lane];
+
+			std::fill(time + partitionSize * 2, time + partitionSize * 4, 0.f);
+			set.fft->performRealOnlyForwardTransform(time, true);
+
+			const auto* spectrum = reinterpret_cast<const Complex*>(time);
+			std::copy(spectrum, spectrum + numBins, getSlot(lane, newestPartition, numBins));
+		}
+
+		stepBands = juce::jmax(set.numBands, previousKernels != nullptr ? previousKernels->numBands : 0);
+
+		for (size_t band = 0; band < (size_t)maxBands; ++band)
+		{
+			auto* out = reinterpret_cast<FloatType*>(outputs.getChannelPointer(band));
+
+			if (band >= (size_t)stepBands)
+			{
+				std::fill(out, out + partitionSize * numLanes, FloatType());
+				continue;
+			}
+
+			for (size_t lane = 0; lane < numLanes; ++lane)
+			{
+				convolve(set, (int)band, lane, scratch.get());
+
+				if (previousKernels == nullptr)
+				{
+					for (size_t i = 0; i < partitionSize; ++i)
+						out[i * numLanes + lane] = (FloatType)scratch[partitionSize + i];
+
+					continue;
+				}
+
+				convolve(*previousKernels, (int)band, lane, fadeScratch.get());
+				const auto step = 1.f / (float)partitionSize;
+
+				for (size_t i = 0; i < partitionSize; ++i)
+				{
+					const auto from = fadeScratch[partitionSize + i];
+					out[i * numLanes + lane] = (FloatType)(from + (scratch[partitionSize + i] - from) * step * (float)(i + 1));
+				}
+			}
+		}
+
+		previousKernels = nullptr;
+
+		// Slide the newest partition into the first half for the next overlap-save step.
+		auto* segment = input.getChannelPointer(0);
+		std::copy(segment + partitionSize, segment + partitionSize * 2, segment);
+	}
+
+	/** One band of one lane into the second half of time; bands the set doesn't have come out silent. */
+	void convolve(const KernelSet& set, int band, size_t lane, float* time) const noexcept
+	{
+		const auto partitionSize = (size_t)set.partitionSize;
+		const auto numPartitions = (size_t)set.numPartitions;
+		const auto numBins = (size_t)set.getNumBins();
+
+		if (band >= set.numBands)
+		{
+			std::fill(time + partitionSize, time + partitionSize * 2, 0.f);
+			return;
+		}
+
+		auto* sum = reinterpret_cast<Complex*>(time);
+		std::fill(sum, sum + numBins, Complex());
+
+		for (size_t partition = 0; partition < numPartitions; ++partition)
+		{
+			const auto slot = newestPartition + partition < numPartitions ? newestPartition + partition
+				: newestPartition + partition - numPartitions;
+			const auto* x = getSlot(lane, slot, numBins);
+			const auto* h = set.getPartition(band, (int)partition);
+
+			for (size_t bin = 0; bin < numBins; ++bin)
+				sum[bin] += x[bin] * h[bin];
+		}
+
+		set.fft->performRealOnlyInverseTransform(time);
+	}
+
+	Complex* getSlot(size_t lane, size_t partition, size_t numBins) const noexcept
+	{
+		return history.get() + lane * spectrumSize + partition * numBins;
+	}
+
+	const KernelSet* kernels = nullptr;
+	const KernelSet* previousKernels = nullptr;
+	int numBands = 0, stepBands = 0;
+	size_t fill = 0, newestPartition = 0, spectrumSize = 0;
+
+	juce::HeapBlock<char> bandData, inputData, outputData;
+	juce::dsp::AudioBlock<Register> bands, input, outputs;
+
+	juce::HeapBlock<Complex> history;
+	juce::HeapBlock<float> scratch, fadeScratch;
+};
@@ -0,0 +1,113 @@
+/*
+  ==============================================================================
+
+	Per-instance CPU load and deadline tracking, published for the editor.
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+
+//==============================================================================
+/**
+	Measures each processBlock call against the real-time budget of the block
+	(its length in seconds) and publishes the results through atomics, so the
+	editor can poll them without touching the audio thread.
+
+	Load is time spent / budget: 1.0 means the block took exactly as long to
+	compute as it takes to play.
+*/
+class LoadMeter
+{
+public:
+	struct Snapshot
+	{
+		float averageLoad = 0.f;
+		float peakLoad = 0.f;
+		int nearMisses = 0;
+		int overruns = 0;
+	};
+
+	/** Blocks above this load count as near misses; above 1.0 as overruns. */
+	static constexpr float nearMissThreshold = 0.8f;
+	static constexpr double averagingTimeSeconds = 1.0;
+
+	void prepare(double newSampleRate) noexcept
+	{
+		sampleRate = newSampleRate;
+		reset();
+	}
+
+	void reset() noexcept
+	{
+		smoothedLoad = 0.f;
+		averageLoad.store(0.f, std::memory_order_relaxed);
+		peakLoad.store(0.f, std::memory_order_relaxed);
+		nearMisses.store(0, std::memory_order_relaxed);
+		overruns.store(0, std::memory_order_relaxed);
+	}
+
+	/** Times its own lifetime as one block of numSamples. */
+	class ScopedMeasurement
+	{
+	public:
+		ScopedMeasurement(LoadMeter& owner, int blockSamples) noexcept
+			: meter(owner), numSamples(blockSamples), start(juce::Time::getHighResolutionTicks())
+		{
+		}
+
+		~ScopedMeasurement()
+		{
+			meter.addBlock(numSamples, juce::Time::getHighResolutionTicks() - start);
+		}
+
+	private:
+		LoadMeter& meter;
+		const int numSamples;
+		const juce::int64 start;
+
+		JUCE_DECLARE_NON_COPYABLE(ScopedMeasurement)
+	};
+
+	/** Audio thread only. */
+	void addBlock(int numSamples, juce::int64 elapsedTicks) noexcept
+	{
+		if (numSamples <= 0)
+			return;
+
+		const auto budget = numSamples / sampleRate;
+		const auto load = (float)(juce::Time::highResolutionTicksToSeconds(elapsedTicks) / budget);
+
+		// One-pole average with a fixed time constant, whatever the block size.
+		smoothedLoad += (load - smoothedLoad) * (float)(1.0 - std::exp(-budget / averagingTimeSeconds));
+		averageLoad.store(smoothedLoad, std::memory_order_relaxed);
+
+		auto peak = peakLoad.load(std::memory_order_relaxed);
+		while (load > peak && !peakLoad.compare_exchange_weak(peak, load, std::memory_order_relaxed)) {}
+
+		if (load >= 1.f)
+			overruns.fetch_add(1, std::memory_order_relaxed);
+		else if (load >= nearMissThreshold)
+			nearMisses.fetch_add(1, std::memory_order_relaxed);
+	}
+
+	/** For the editor; the peak is the highest since the previous snapshot. */
+	Snapshot takeSnapshot() noexcept
+	{
+		Snapshot snapshot;
+		snapshot.averageLoad = averageLoad.load(std::memory_order_relaxed);
+		snapshot.peakLoad = peakLoad.exchange(0.f, std::memory_order_relaxed);
+		snapshot.nearMisses = nearMisses.load(std::memory_order_relaxed);
+		snapshot.overruns = overruns.load(std::memory_order_relaxed);
+		return snapshot;
+	}
+
+private:
+	double sampleRate = 44100.0;
+	float smoothedLoad = 0.f;
+
+	std::atomic<float> averageLoad{ 0.f }, peakLoad{ 0.f };
+	std::atomic<int> nearMisses{ 0 }, overruns{ 0 };
+};
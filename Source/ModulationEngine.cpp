@@ -0,0 +1,196 @@
+/*
+  ==============================================================================
+
+	Control-rate modulation: LFOs and macros routed to band and peak targets.
+
+  ==============================================================================
+*/
+
+#include "ModulationEngine.h"
+
+void ModulationEngine::prepare(double newSampleRate, int maximumBlockSize)
+{
+	sampleRate = newSampleRate;
+
+	// A tick can land on the first sample of a segment as well as every interval after it.
+	const auto maximumTicks = (size_t)(maximumBlockSize / minimumInterval + 2);
+	tickPositions.resize(maximumTicks);
+	tickPeaks.resize(maximumTicks);
+
+	driveModulation.setSize(maxBands, maximumBlockSize);
+	mixModulation.setSize(maxBands, maximumBlockSize);
+
+	reset();
+}
+
+void ModulationEngine::reset() noexcept
+{
+	lfoPhases.fill(0.0);
+	samplesUntilTick = 0;
+	numTicks = 0;
+	active = false;
+}
+
+void ModulationEngine::process(const ChainSettings& settings, int numSamples) noexcept
+{
+	// The processor never hands over more than it prepared for, but it may run before it is prepared.
+	if (numSamples > driveModulation.getNumSamples())
+	{
+		active = false;
+		numTicks = 0;
+		return;
+	}
+
+	const auto wasActive = active;
+	active = peakTargeted = crossoversTargeted = false;
+	driveTargeted.fill(false);
+	mixTargeted.fill(false);
+	numTicks = 0;
+
+	for (const auto& slot : settings.modulationSlots)
+	{
+		if (slot.source <= 0 || slot.depth == 0.f || !juce::isPositiveAndBelow(slot.target, (int)numModulationTargets))
+			continue;
+
+		active = true;
+
+		if (slot.target < Target_Crossover)
+			peakTargeted = true;
+		else if (slot.target < Target_BandDrive)
+			crossoversTargeted = true;
+		else if (slot.target < Target_BandMix)
+			driveTargeted[(size_t)(slot.target - Target_BandDrive)] = true;
+		else
+			mixTargeted[(size_t)(slot.target - Target_BandMix)] = true;
+	}
+
+	if (!active)
+		return;
+
+	// Starting up, the first tick lands straight away rather than ramping from stale values.
+	if (!wasActive)
+	{
+		evaluate(settings, next);
+		samplesUntilTick = 0;
+	}
+
+	interval = settings.modulationInterval;
+	samplesUntilTick = juce::jmin(samplesUntilTick, interval);
+
+	for (auto position = 0; position < numSamples;)
+	{
+		if (samplesUntilTick == 0)
+		{
+			tick(settings);
+			samplesUntilTick = interval;
+
+			if (numTicks < (int)tickPositions.size())
+			{
+				tickPositions[(size_t)numTicks] = position;
+				tickPeaks[(size_t)numTicks] = { current[Target_PeakGain] * gainRangeInDecibels,
+					std::exp2(current[Target_PeakFreq] * peakFrequencyOctaves),
+					std::exp2(current[Target_PeakQuality] * qualityOctaves) };
+				++numTicks;
+			}
+		}
+
+		const auto length = juce::jmin(samplesUntilTick, numSamples - position);
+		const auto elapsed = (float)(interval - samplesUntilTick);
+
+		for (size_t band = 0; band < (size_t)maxBands; ++band)
+		{
+			if (driveTargeted[band])
+			{
+				auto* drive = driveModulation.getWritePointer((int)band, position);
+
+				for (int i = 0; i < length; ++i)
+					drive[i] = driveStart[band] + driveStep[band] * (elapsed + (float)i);
+			}
+
+			if (mixTargeted[band])
+			{
+				auto* mix = mixModulation.getWritePointer((int)band, position);
+
+				for (int i = 0; i < length; ++i)
+					mix[i] = mixStart[band] + mixStep[band] * (elapsed + (float)i);
+			}
+		}
+
+		position += length;
+		samplesUntilTick -= length;
+	}
+}
+
+void ModulationEngine::modulateCrossovers(std::array<float, maxBands - 1>& frequencies) const noexcept
+{
+	for (size_t i = 0; i < frequencies.size(); ++i)
+		frequencies[i] *= std::exp2(current[(size_t)Target_Crossover + i] * crossoverOctaves);
+}
+
+const float* ModulationEngine::getDriveModulation(size_t band) const noexcept
+{
+	return active && driveTargeted[band] ? driveModulation.getReadPointer((int)band) : nullptr;
+}
+
+const float* ModulationEngine::getMixModulation(size_t band) const noexcept
+{
+	return active && mixTargeted[band] ? mixModulation.getReadPointer((int)band) : nullptr;
+}
+
+void ModulationEngine::tick(const ChainSettings& settings) noexcept
+{
+	current = next;
+
+	for (size_t lfo = 0; lfo < lfoPhases.size(); ++lfo)
+	{
+		auto& phase = lfoPhases[lfo];
+		phase += (double)settings.lfoRates[lfo] * (double)interval / sampleRate;
+		phase -= std::floor(phase);
+	}
+
+	evaluate(settings, next);
+
+	// Gains are interpolated rather than decibels, so the per-sample loops stay free of exp().
+	const auto inverseInterval = 1.f / (float)interval;
+
+	for (size_t band = 0; band < (size_t)maxBands; ++band)
+	{
+		const auto drive = (size_t)Target_BandDrive + band;
+		const auto mix = (size_t)Target_BandMix + band;
+
+		driveStart[band] = juce::Decibels::decibelsToGain(current[drive] * driveRangeInDecibels, -1000.f);
+		driveStep[band] = (juce::Decibels::decibelsToGain(next[drive] * driveRangeInDecibels, -1000.f) - driveStart[band]) * inverseInterval;
+		mixStart[band] = current[mix];
+		mixStep[band] = (next[mix] - current[mix]) * inverseInterval;
+	}
+}
+
+void ModulationEngine::evaluate(const ChainSettings& settings, Amounts& amounts) const noexcept
+{
+	// Indexed by a slot's source choice: off, the LFOs, then the macros.
+	std::array<float, 1 + numLfos + numMacros> sources{};
+
+	for (int lfo = 0; lfo < numLfos; ++lfo)
+		sources[(size_t)getLfoSource(lfo)] = getLfoValue(settings.lfoShapes[(size_t)lfo], lfoPhases[(size_t)lfo]);
+
+	for (int macro = 0; macro < numMacros; ++macro)
+		sources[(size_t)getMacroSource(macro)] = settings.macros[(size_t)macro];
+
+	amounts.fill(0.f);
+
+	for (const auto& slot : settings.modulationSlots)
+		if (juce::isPositiveAndBelow(slot.source, (int)sources.size()) && juce::isPositiveAndBelow(slot.target, (int)numModulationTargets))
+			amounts[(size_t)slot.target] += slot.depth * sources[(size_t)slot.source];
+}
+
+float ModulationEngine::getLfoValue(int shape, double phase) noexcept
+{
+	switch (shape)
+	{
+		case 1:  return (float)(4.0 * std::abs(phase - 0.5) - 1.0);
+		case 2:  return (float)(2.0 * phase - 1.0);
+		case 3:  return phase < 0.5 ? 1.f : -1.f;
+		case 0:
+		default: return (float)std::sin(juce::MathConstants<double>::twoPi * phase);
+	}
+}
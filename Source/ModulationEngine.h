@@ -0,0 +1,106 @@
+/*
+  ==============================================================================
+
+	Control-rate modulation: LFOs and macros routed to band and peak targets.
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+#include "ChainSettings.h"
+#include "CoefficientEngine.h"
+
+//==============================================================================
+/**
+	Evaluates the modulation slots once every control interval (16 to 128
+	samples) rather than per sample, and hands the results to each target at the
+	rate it needs:
+
+	- the peak takes a new PeakModulation on every tick, and the CoefficientEngine
+	  only rebuilds its coefficients when that value moved;
+	- the IIR crossovers take the value of the tick a segment starts on, which is
+	  why the processor cuts segments at ticks while a crossover is modulated;
+	- band drive and mix are linearly interpolated between ticks into per-sample
+	  buffers, since a stepped gain ahead of a waveshaper is audible.
+
+	Each tick evaluates the sources one interval ahead and the interpolated targets
+	ramp towards that value, so they arrive on the next tick exactly. The LFO
+	phases carry across segments and blocks.
+*/
+class ModulationEngine
+{
+public:
+	using PeakModulation = CoefficientEngine::PeakModulation;
+
+	/** The shortest control interval the "Modulation Rate" choices offer. */
+	static constexpr int minimumInterval = 16;
+
+	ModulationEngine() = default;
+
+	/** Sizes the tick and per-sample buffers for the largest block; the only place this allocates. */
+	void prepare(double newSampleRate, int maximumBlockSize);
+
+	/** Restarts the LFOs and drops any ramp in progress. */
+	void reset() noexcept;
+
+	/** Audio thread. Evaluates the ticks falling in the next numSamples and fills the band buffers. */
+	void process(const ChainSettings& settings, int numSamples) noexcept;
+
+	/** True while any slot has both a source and a depth. */
+	bool isActive() const noexcept { return active; }
+	bool modulatesPeak() const noexcept { return active && peakTargeted; }
+	bool modulatesCrossovers() const noexcept { return active && crossoversTargeted; }
+
+	/** Samples from the end of the last processed segment to the next tick. */
+	int getSamplesUntilTick() const noexcept { return samplesUntilTick > 0 ? samplesUntilTick : interval; }
+
+	/** The ticks in the last processed segment, by position, and the peak modulation each one set. */
+	int getNumTicks() const noexcept { return numTicks; }
+	int getTickPosition(int tick) const noexcept { return tickPositions[(size_t)tick]; }
+	const PeakModulation& getPeakModulation(int tick) const noexcept { return tickPeaks[(size_t)tick]; }
+
+	/** Scales the crossover frequencies by the current tick's modulation. */
+	void modulateCrossovers(std::array<float, maxBands - 1>& frequencies) const noexcept;
+
+	/** Per-sample drive multipliers and mix offsets for the last segment, or nullptr for an unmodulated band. */
+	const float* getDriveModulation(size_t band) const noexcept;
+	const float* getMixModulation(size_t band) const noexcept;
+
+	/** How far a depth of 100% moves each kind of target. */
+	static constexpr float gainRangeInDecibels = 24.f;
+	static constexpr float peakFrequencyOctaves = 4.f;
+	static constexpr float qualityOctaves = 2.f;
+	static constexpr float crossoverOctaves = 2.f;
+	static constexpr float driveRangeInDecibels = 24.f;
+
+private:
+	using Amounts = std::array<float, numModulationTargets>;
+
+	void tick(const ChainSettings& settings) noexcept;
+	void evaluate(const ChainSettings& settings, Amounts& amounts) const noexcept;
+	static float getLfoValue(int shape, double phase) noexcept;
+
+	double sampleRate = 44100.0;
+	int interval = 32;
+	int samplesUntilTick = 0;
+	bool active = false, peakTargeted = false, crossoversTargeted = false;
+
+	std::array<double, numLfos> lfoPhases{};
+
+	// The summed depth times source of every target, at the last tick and one interval on.
+	Amounts current{}, next{};
+
+	// Interpolated targets as gains and offsets, so the per-sample loop only adds.
+	std::array<float, maxBands> driveStart{}, driveStep{}, mixStart{}, mixStep{};
+	std::array<bool, maxBands> driveTargeted{}, mixTargeted{};
+
+	std::vector<int> tickPositions;
+	std::vector<PeakModulation> tickPeaks;
+	int numTicks = 0;
+
+	juce::AudioBuffer<float> driveModulation, mixModulation;
+
+	JUCE_DECLARE_NON_COPYABLE(ModulationEngine)
+};
@@ -0,0 +1,392 @@
+/*
+  ==============================================================================
+
+	Half-band oversampling for the nonlinear part of each band.
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+
+//==============================================================================
+/**
+	One 2x up/down stage working on SIMD-interleaved samples. Upsampling and
+	downsampling keep separate state, so one object serves both directions.
+*/
+template <typename FloatType>
+class HalfBandFilter
+{
+public:
+	using Register = juce::dsp::SIMDRegister<FloatType>;
+
+	virtual ~HalfBandFilter() = default;
+
+	virtual void reset() noexcept = 0;
+
+	/** Writes 2 * numInputSamples samples to output. */
+	virtual void upsample(const Register* input, Register* output, size_t numInputSamples) noexcept = 0;
+
+	/** Reads 2 * numOutputSamples samples from input. */
+	virtual void downsample(const Register* input, Register* output, size_t numOutputSamples) noexcept = 0;
+
+	/** Delay of an upsample/downsample round trip, in samples at the higher rate. */
+	virtual double getRoundTripLatency() const noexcept = 0;
+};
+
+//==============================================================================
+/**
+	Minimum-phase half-band made of two parallel chains of first-order allpasses
+	running at the lower rate (the polyphase IIR structure also used by
+	juce::dsp::Oversampling). The allpass coefficients come from the elliptic
+	half-band design in designCoefficients().
+*/
+template <typename FloatType>
+class PolyphaseIIRHalfBand : public HalfBandFilter<FloatType>
+{
+public:
+	using Register = typename HalfBandFilter<FloatType>::Register;
+
+	PolyphaseIIRHalfBand(double attenuationInDecibels, double transitionWidth)
+	{
+		for (auto coefficient : designCoefficients(attenuationInDecibels, transitionWidth))
+			coefficients.push_back((FloatType)coefficient);
+
+		upX.resize(coefficients.size());
+		upY.resize(coefficients.size());
+		downX.resize(coefficients.size());
+		downY.resize(coefficients.size());
+
+		// Each section's DC group delay is (1 - a) / (1 + a) low-rate samples, i.e. twice that at the higher rate.
+		double pathDelays[2]{};
+
+		for (size_t i = 0; i < coefficients.size(); ++i)
+			pathDelays[i & 1] += 2.0 * (1.0 - coefficients[i]) / (1.0 + coefficients[i]);
+
+		latency = pathDelays[0] + pathDelays[1] + 1.0;
+	}
+
+	void reset() noexcept override
+	{
+		std::fill(upX.begin(), upX.end(), Register());
+		std::fill(upY.begin(), upY.end(), Register());
+		std::fill(downX.begin(), downX.end(), Register());
+		std::fill(downY.begin(), downY.end(), Register());
+	}
+
+	void upsample(const Register* input, Register* output, size_t numInputSamples) noexcept override
+	{
+		for (size_t i = 0; i < numInputSamples; ++i)
+		{
+			auto even = input[i];
+			auto odd = input[i];
+			processPaths(even, odd, upX.data(), upY.data());
+
+			output[i << 1] = even;
+			output[(i << 1) + 1] = odd;
+		}
+	}
+
+	void downsample(const Register* input, Register* output, size_t numOutputSamples) noexcept override
+	{
+		for (size_t i = 0; i < numOutputSamples; ++i)
+		{
+			auto first = input[(i << 1) + 1];
+			auto second = input[i << 1];
+			processPaths(first, second, downX.data(), downY.data());
+
+			output[i] = (first + second) * (FloatType)0.5;
+		}
+	}
+
+	double getRoundTripLatency() const noexcept override { return latency; }
+
+	/** Allpass coefficients for an elliptic half-band with the given stopband and transition (0 to 0.5). */
+	static std::vector<double> designCoefficients(double attenuationInDecibels, double transitionWidth)
+	{
+		using juce::MathConstants;
+
+		auto k = std::tan((1.0 - transitionWidth * 2.0) * MathConstants<double>::pi / 4.0);
+		k *= k;
+
+		const auto kRoot = std::pow(1.0 - k * k, 0.25);
+		const auto e = 0.5 * (1.0 - kRoot) / (1.0 + kRoot);
+		const auto e4 = e * e * e * e;
+		const auto q = e * (1.0 + e4 * (2.0 + e4 * (15.0 + 150.0 * e4)));
+
+		const auto attenuation = std::pow(10.0, -attenuationInDecibels / 10.0);
+		const auto a = attenuation / (1.0 - attenuation);
+		auto order = (int)std::ceil(std::log(a * a / 16.0) / std::log(q));
+		order = juce::jmax(3, order | 1);
+
+		std::vector<double> result;
+
+		for (int c = 1; c <= (order - 1) / 2; ++c)
+		{
+			double numerator = 0.0, denominator = 0.0, term = 0.0;
+			int sign = 1;
+
+			for (int i = 0; i == 0 || std::abs(term) > 1.0e-100; ++i, sign = -sign)
+			{
+				term = std::pow(q, (double)(i * (i + 1))) * std::sin((i * 2 + 1) * c * MathConstants<double>::pi / order) * sign;
+				numerator += term;
+			}
+
+			sign = -1;
+
+			for (int i = 1; i == 1 || std::abs(term) > 1.0e-100; ++i, sign = -sign)
+			{
+				term = std::pow(q, (double)(i * i)) * std::cos(i * 2 * c * MathConstants<double>::pi / order) * sign;
+				denominator += term;
+			}
+
+			const auto w = numerator * std::pow(q, 0.25) / (denominator + 0.5);
+			const auto w2 = w * w;
+			const auto x = std::sqrt((1.0 - w2 * k) * (1.0 - w2 / k)) / (1.0 + w2);
+			result.push_back((1.0 - x) / (1.0 + x));
+		}
+
+		return result;
+	}
+
+private:
+	/** Even coefficients feed the first path, odd ones the second. */
+	void processPaths(Register& first, Register& second, Register* x, Register* y) const noexcept
+	{
+		const auto numCoefficients = coefficients.size();
+		size_t i = 0;
+
+		for (; i + 1 < numCoefficients; i += 2)
+		{
+			auto out0 = (first - y[i]) * coefficients[i] + x[i];
+			auto out1 = (second - y[i + 1]) * coefficients[i + 1] + x[i + 1];
+			x[i] = first;
+			x[i + 1] = second;
+			y[i] = first = out0;
+			y[i + 1] = second = out1;
+		}
+
+		if (i < numCoefficients)
+		{
+			auto out0 = (first - y[i]) * coefficients[i] + x[i];
+			x[i] = first;
+			y[i] = first = out0;
+		}
+	}
+
+	std::vector<FloatType> coefficients;
+	std::vector<Register> upX, upY, downX, downY;
+	double latency = 0.0;
+};
+
+//==============================================================================
+/**
+	Linear-phase half-band FIR from juce::dsp::FilterDesign, run as two polyphase
+	branches at the lower rate. The zero taps a half-band has are skipped.
+*/
+template <typename FloatType>
+class EquirippleFIRHalfBand : public HalfBandFilter<FloatType>
+{
+public:
+	using Register = typename HalfBandFilter<FloatType>::Register;
+
+	EquirippleFIRHalfBand(double attenuationInDecibels, double transitionWidth)
+	{
+		auto design = juce::dsp::FilterDesign<FloatType>::designFIRLowpassHalfBandEquirippleMethod((FloatType)transitionWidth, (FloatType)-attenuationInDecibels);
+		const auto& h = design->coefficients;
+
+		for (int k = 0; k < h.size(); ++k)
+		{
+			if (std::abs(h[k]) > (FloatType)1.0e-9)
+			{
+				branches[(size_t)(k & 1)].offsets.push_back((size_t)(k >> 1));
+				branches[(size_t)(k & 1)].taps.push_back(h[k]);
+			}
+		}
+
+		historyLength = (size_t)(h.size() + 1) / 2 + 1;
+		upHistory.resize(historyLength * 2);
+		evenHistory.resize(historyLength * 2);
+		oddHistory.resize(historyLength * 2);
+
+		latency = (double)(h.size() - 1);
+	}
+
+	void reset() noexcept override
+	{
+		std::fill(upHistory.begin(), upHistory.end(), Register());
+		std::fill(evenHistory.begin(), evenHistory.end(), Register());
+		std::fill(oddHistory.begin(), oddHistory.end(), Register());
+		upPosition = evenPosition = oddPosition = 0;
+	}
+
+	void upsample(const Register* input, Register* output, size_t numInputSamples) noexcept override
+	{
+		for (size_t i = 0; i < numInputSamples; ++i)
+		{
+			auto* window = push(upHistory, upPosition, input[i]);
+
+			// Zero stuffing halves the level, hence the factor of two.
+			output[i << 1] = branches[0].apply(window) * (FloatType)2;
+			output[(i << 1) + 1] = branches[1].apply(window) * (FloatType)2;
+		}
+	}
+
+	void downsample(const Register* input, Register* output, size_t numOutputSamples) noexcept override
+	{
+		for (size_t i = 0; i < numOutputSamples; ++i)
+		{
+			// The odd branch reads the odd samples one step behind the even ones.
+			auto* evenWindow = push(evenHistory, evenPosition, input[i << 1]);
+			auto* oddWindow = oddHistory.data() + oddPosition;
+
+			output[i] = branches[0].apply(evenWindow) + branches[1].apply(oddWindow);
+			push(oddHistory, oddPosition, input[(i << 1) + 1]);
+		}
+	}
+
+	double getRoundTripLatency() const noexcept override { return latency; }
+
+private:
+	struct Branch
+	{
+		Register apply(const Register* window) const noexcept
+		{
+			auto sum = Register::expand((FloatType)0);
+
+			for (size_t j = 0; j < taps.size(); ++j)
+				sum += window[offsets[j]] * taps[j];
+
+			return sum;
+		}
+
+		std::vector<size_t> offsets;
+		std::vector<FloatType> taps;
+	};
+
+	/** Newest sample first; writing it twice keeps the whole window contiguous. */
+	Register* push(std::vector<Register>& history, size_t& position, Register sample) noexcept
+	{
+		position = (position == 0 ? historyLength : position) - 1;
+		history[position] = history[position + historyLength] = sample;
+		return history.data() + position;
+	}
+
+	std::array<Branch, 2> branches;
+	std::vector<Register> upHistory, evenHistory, oddHistory;
+	size_t historyLength = 0, upPosition = 0, evenPosition = 0, oddPosition = 0;
+	double latency = 0.0;
+};
+
+//==============================================================================
+/**
+	Cascade of up to three 2x stages (2x, 4x, 8x) around a band's nonlinearity.
+
+	Both filter types are designed and every buffer is allocated in prepare(), so
+	switching factor or filter type on the audio thread only changes which of
+	them are used.
+*/
+template <typename FloatType>
+class BandOversampler
+{
+public:
+	using Register = juce::dsp::SIMDRegister<FloatType>;
+
+	enum class FilterType
+	{
+		MinimumPhaseIIR,
+		LinearPhaseFIR
+	};
+
+	static constexpr int maxStages = 3;
+
+	void prepare(int maximumBlockSize)
+	{
+		buffers = juce::dsp::AudioBlock<Register>(bufferData, (size_t)maxStages, (size_t)maximumBlockSize << maxStages);
+
+		for (int stage = 0; stage < maxStages; ++stage)
+		{
+			// The first stage does the real anti-aliasing; later ones only see content
+			// below the base-rate Nyquist and can use much wider transitions.
+			const auto transition = stage == 0 ? 0.05 : 0.2;
+			iirStages[(size_t)stage] = std::make_unique<PolyphaseIIRHalfBand<FloatType>>(90.0, transition);
+			firStages[(size_t)stage] = std::make_unique<EquirippleFIRHalfBand<FloatType>>(90.0, transition);
+		}
+
+		reset();
+	}
+
+	void reset() noexcept
+	{
+		for (int stage = 0; stage < maxStages; ++stage)
+		{
+			iirStages[(size_t)stage]->reset();
+			firStages[(size_t)stage]->reset();
+		}
+	}
+
+	void setConfiguration(int newNumStages, FilterType newFilterType) noexcept
+	{
+		numStages = juce::jlimit(0, maxStages, newNumStages);
+		filterType = newFilterType;
+	}
+
+	int getNumStages() const noexcept { return numStages; }
+	FilterType getFilterType() const noexcept { return filterType; }
+
+	/** Base-rate latency of the current configuration. */
+	double getLatencyInSamples() const noexcept
+	{
+		double latency = 0.0;
+
+		for (int stage = 0; stage < numStages; ++stage)
+			latency += getStage(stage).getRoundTripLatency() / (double)(2 << stage);
+
+		return latency;
+	}
+
+	/** Returns the input itself at 1x, otherwise a block at the oversampled rate. */
+	juce::dsp::AudioBlock<Register> processUp(const juce::dsp::AudioBlock<Register>& input) noexcept
+	{
+		if (numStages == 0)
+			return input;
+
+		const auto numSamples = input.getNumSamples();
+		const Register* source = input.getChannelPointer(0);
+
+		for (int stage = 0; stage < numStages; ++stage)
+		{
+			auto* destination = buffers.getChannelPointer((size_t)stage);
+			getStage(stage).upsample(source, destination, numSamples << stage);
+			source = destination;
+		}
+
+		return buffers.getSingleChannelBlock((size_t)numStages - 1).getSubBlock(0, numSamples << numStages);
+	}
+
+	void processDown(const juce::dsp::AudioBlock<Register>& output) noexcept
+	{
+		const auto numSamples = output.getNumSamples();
+
+		for (int stage = numStages - 1; stage >= 0; --stage)
+		{
+			auto* destination = stage == 0 ? output.getChannelPointer(0) : buffers.getChannelPointer((size_t)stage - 1);
+			getStage(stage).downsample(buffers.getChannelPointer((size_t)stage), destination, numSamples << stage);
+		}
+	}
+
+private:
+	HalfBandFilter<FloatType>& getStage(int stage) const noexcept
+	{
+		return filterType == FilterType::LinearPhaseFIR ? *firStages[(size_t)stage] : *iirStages[(size_t)stage];
+	}
+
+	std::array<std::unique_ptr<HalfBandFilter<FloatType>>, maxStages> iirStages, firStages;
+
+	juce::HeapBlock<char> bufferData;
+	juce::dsp::AudioBlock<Register> buffers;
+
+	int numStages = 0;
+	FilterType filterType = FilterType::MinimumPhaseIIR;
+};
@@ -0,0 +1,79 @@
+/*
+  ==============================================================================
+
+	The plug-in's parameters, declared once: the layout, the typed reads the DSP
+	works from and the editor attachments are all generated from this table.
+
+  ==============================================================================
+*/
+
+#include "ParameterRegistry.h"
+
+juce::String getParameterID(Param param, int index)
+{
+	const auto& descriptor = getDescriptor(param);
+	jassert(juce::isPositiveAndBelow(index, descriptor.count));
+
+	const juce::String id(descriptor.id);
+	return descriptor.count > 1 ? id.replace("#", juce::String(index + 1)) : id;
+}
+
+std::unique_ptr<juce::RangedAudioParameter> makeParameter(const ParameterDescriptor& descriptor, int index)
+{
+	const auto id = getParameterID(descriptor.param, index);
+	const auto defaultValue = descriptor.defaults != nullptr ? descriptor.defaults[index] : descriptor.defaultValue;
+
+	switch (descriptor.kind)
+	{
+		case ParameterKind::Int:
+			return std::make_unique<juce::AudioParameterInt>(id, id, (int)descriptor.minimum, (int)descriptor.maximum, (int)defaultValue);
+
+		case ParameterKind::Choice:
+			return std::make_unique<juce::AudioParameterChoice>(id, id, descriptor.getChoices(), (int)defaultValue);
+
+		case ParameterKind::Bool:
+			return std::make_unique<juce::AudioParameterBool>(id, id, defaultValue >= 0.5f);
+
+		case ParameterKind::Float:
+		default:
+			return std::make_unique<juce::AudioParameterFloat>(id, id,
+				juce::NormalisableRange<float>(descriptor.minimum, descriptor.maximum, descriptor.interval, descriptor.skew), defaultValue);
+	}
+}
+
+ParameterValues::ParameterValues(juce::AudioProcessorValueTreeState& apvts)
+{
+	forEachParameter([this, &apvts](const ParameterDescriptor& descriptor, int index)
+	{
+		auto* value = apvts.getRawParameterValue(getParameterID(descriptor.param, index));
+		jassert(value != nullptr);
+		values[(size_t)getParameterSlot(descriptor.param, index)] = value;
+	});
+}
+
+std::unique_ptr<juce::AudioProcessorValueTreeState::SliderAttachment> attachParameter(
+	juce::AudioProcessorValueTreeState& apvts, Param param, juce::Slider& slider, int index)
+{
+	jassert(getDescriptor(param).kind == ParameterKind::Float || getDescriptor(param).kind == ParameterKind::Int);
+	return std::make_unique<juce::AudioProcessorValueTreeState::SliderAttachment>(apvts, getParameterID(param, index), slider);
+}
+
+std::unique_ptr<juce::AudioProcessorValueTreeState::ComboBoxAttachment> attachParameter(
+	juce::AudioProcessorValueTreeState& apvts, Param param, juce::ComboBox& comboBox, int index)
+{
+	const auto& descriptor = getDescriptor(param);
+	jassert(descriptor.kind == ParameterKind::Choice);
+
+	// The attachment selects by item index, so the items have to be there first.
+	comboBox.clear(juce::dontSendNotification);
+	comboBox.addItemList(descriptor.getChoices(), 1);
+
+	return std::make_unique<juce::AudioProcessorValueTreeState::ComboBoxAttachment>(apvts, getParameterID(param, index), comboBox);
+}
+
+std::unique_ptr<juce::AudioProcessorValueTreeState::ButtonAttachment> attachParameter(
+	juce::AudioProcessorValueTreeState& apvts, Param param, juce::Button& button, int index)
+{
+	jassert(getDescriptor(param).kind == ParameterKind::Bool);
+	return std::make_unique<juce::AudioProcessorValueTreeState::ButtonAttachment>(apvts, getParameterID(param, index), button);
+}
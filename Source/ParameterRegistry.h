@@ -0,0 +1,364 @@
+/*
+  ==============================================================================
+
+	The plug-in's parameters, declared once: the layout, the typed reads the DSP
+	works from and the editor attachments are all generated from this table.
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+#include "ChainSettings.h"
+#include "Waveshaper.h"
+
+/** Every parameter, or family of numbered parameters, in layout order. */
+enum class Param
+{
+	PeakGain,
+	LowCutFreq,
+	HighCutFreq,
+	LowCutSlope,
+	HighCutSlope,
+	RampInterval,
+	RampMode,
+	BandCount,
+	CrossoverFreq,
+	CrossoverMode,
+	CrossoverPartition,
+	BandDrive,
+	BandMix,
+	BandShape,
+	Oversampling,
+	OversamplingFilter,
+	Antialiasing,
+	ParallelBands,
+	EnvelopeDetector,
+	EnvelopeAttack,
+	EnvelopeRelease,
+	BandDynamics,
+	ModulationRate,
+	LfoRate,
+	LfoShape,
+	ModulationSource,
+	ModulationTarget,
+	ModulationDepth,
+	Macro,
+	EnvelopeLink,
+
+	NumParams
+};
+
+enum class ParameterKind
+{
+	Float,
+	Int,
+	Choice,
+	Bool
+};
+
+struct ParameterDescriptor
+{
+	Param param;
+
+	/** The parameter ID and name; in a numbered family '#' stands for the one-based index. */
+	const char* id;
+
+	ParameterKind kind;
+	float minimum, maximum, interval, skew;
+
+	/** A plain value; the item index for a choice. */
+	float defaultValue;
+
+	/** Number of parameters in a numbered family, each with its own ID. */
+	int count = 1;
+
+	/** Per-index defaults for a family, overriding defaultValue. */
+	const float* defaults = nullptr;
+
+	juce::StringArray (*getChoices)() = nullptr;
+};
+
+//==============================================================================
+inline juce::StringArray getSlopeChoices()
+{
+	juce::StringArray slopes;
+
+	for (int stages = 1; stages <= maxCutStages; ++stages)
+		slopes.add(juce::String(12 * stages) + " db/Oct");
+
+	return slopes;
+}
+
+inline juce::StringArray getPartitionChoices()
+{
+	juce::StringArray sizes;
+
+	for (int order = minCrossoverPartitionOrder; order <= maxCrossoverPartitionOrder; ++order)
+		sizes.add(juce::String(1 << order));
+
+	return sizes;
+}
+
+inline juce::StringArray getRampIntervalChoices() { return { "16", "32", "64" }; }
+inline juce::StringArray getRampModeChoices() { return { "Sub-block", "Per-sample" }; }
+inline juce::StringArray getFilterPhaseChoices() { return { "Minimum Phase IIR", "Linear Phase FIR" }; }
+inline juce::StringArray getOversamplingChoices() { return { "1x", "2x", "4x", "8x" }; }
+inline juce::StringArray getAntialiasingChoices() { return { "Off", "ADAA 1st Order", "ADAA 2nd Order" }; }
+inline juce::StringArray getShapeChoices() { return getWaveshaperCurveNames(); }
+inline juce::StringArray getDetectorChoices() { return { "Peak", "RMS" }; }
+inline juce::StringArray getLinkChoices() { return { "Unlinked", "Max", "Mean" }; }
+inline juce::StringArray getModulationRateChoices() { return { "16", "32", "64", "128" }; }
+inline juce::StringArray getLfoShapeChoices() { return { "Sine", "Triangle", "Saw", "Square" }; }
+
+inline juce::StringArray getModulationSourceChoices()
+{
+	juce::StringArray sources{ "Off" };
+
+	for (int lfo = 0; lfo < numLfos; ++lfo)
+		sources.add("LFO " + juce::String(lfo + 1));
+
+	for (int macro = 0; macro < numMacros; ++macro)
+		sources.add("Macro " + juce::String(macro + 1));
+
+	return sources;
+}
+
+inline juce::StringArray getModulationTargetChoices()
+{
+	juce::StringArray targets{ "Peak Gain", "Peak Freq", "Peak Q" };
+
+	for (int i = 0; i < maxBands - 1; ++i)
+		targets.add("Crossover " + juce::String(i + 1) + " Freq");
+
+	for (int band = 0; band < maxBands; ++band)
+		targets.add("Band " + juce::String(band + 1) + " Drive");
+
+	for (int band = 0; band < maxBands; ++band)
+		targets.add("Band " + juce::String(band + 1) + " Mix");
+
+	return targets;
+}
+
+//==============================================================================
+/**
+	The table itself, indexed by Param. Adding a parameter means a Param entry, a
+	row here and, if the DSP reads it, a line in makeChainSettings().
+*/
+inline constexpr std::array<ParameterDescriptor, (size_t)Param::NumParams> parameterDescriptors
+{ {
+	{ Param::PeakGain, "Peak Gain", ParameterKind::Float, -24.f, 24.f, 0.1f, 1.f, 0.f },
+	{ Param::LowCutFreq, "LowCut Freq", ParameterKind::Float, minimumCutFreq, maximumCutFreq, 1.f, 0.25f, minimumCutFreq },
+	{ Param::HighCutFreq, "HighCut Freq", ParameterKind::Float, minimumCutFreq, maximumCutFreq, 1.f, 0.25f, maximumCutFreq },
+	{ Param::LowCutSlope, "LowCut Slope", ParameterKind::Choice, 0.f, 0.f, 0.f, 1.f, 0.f, 1, nullptr, getSlopeChoices },
+	{ Param::HighCutSlope, "HighCut Slope", ParameterKind::Choice, 0.f, 0.f, 0.f, 1.f, 0.f, 1, nullptr, getSlopeChoices },
+	{ Param::RampInterval, "Ramp Interval", ParameterKind::Choice, 0.f, 0.f, 0.f, 1.f, 1.f, 1, nullptr, getRampIntervalChoices },
+	{ Param::RampMode, "Ramp Mode", ParameterKind::Choice, 0.f, 0.f, 0.f, 1.f, 0.f, 1, nullptr, getRampModeChoices },
+	{ Param::BandCount, "Band Count", ParameterKind::Int, 2.f, (float)maxBands, 1.f, 1.f, 3.f },
+	{ Param::CrossoverFreq, "Crossover # Freq", ParameterKind::Float, 20.f, 20000.f, 1.f, 0.25f, 0.f, maxBands - 1, defaultCrossoverFreqs.data() },
+	{ Param::CrossoverMode, "Crossover Mode", ParameterKind::Choice, 0.f, 0.f, 0.f, 1.f, 0.f, 1, nullptr, getFilterPhaseChoices },
+	{ Param::CrossoverPartition, "Crossover Partition", ParameterKind::Choice, 0.f, 0.f, 0.f, 1.f,
+		(float)(defaultCrossoverPartitionOrder - minCrossoverPartitionOrder), 1, nullptr, getPartitionChoices },
+	{ Param::BandDrive, "Band # Drive", ParameterKind::Float, 0.f, 36.f, 0.1f, 1.f, 0.f, maxBands },
+	{ Param::BandMix, "Band # Mix", ParameterKind::Float, 0.f, 100.f, 1.f, 1.f, 100.f, maxBands },
+	{ Param::BandShape, "Band # Shape", ParameterKind::Choice, 0.f, 0.f, 0.f, 1.f, 0.f, maxBands, nullptr, getShapeChoices },
+	{ Param::Oversampling, "Oversampling", ParameterKind::Choice, 0.f, 0.f, 0.f, 1.f, 0.f, 1, nullptr, getOversamplingChoices },
+	{ Param::OversamplingFilter, "Oversampling Filter", ParameterKind::Choice, 0.f, 0.f, 0.f, 1.f, 0.f, 1, nullptr, getFilterPhaseChoices },
+	{ Param::Antialiasing, "Antialiasing", ParameterKind::Choice, 0.f, 0.f, 0.f, 1.f, 0.f, 1, nullptr, getAntialiasingChoices },
+	{ Param::ParallelBands, "Parallel Bands", ParameterKind::Bool, 0.f, 1.f, 1.f, 1.f, 0.f },
+	{ Param::EnvelopeDetector, "Envelope Detector", ParameterKind::Choice, 0.f, 0.f, 0.f, 1.f, 0.f, 1, nullptr, getDetectorChoices },
+	{ Param::EnvelopeAttack, "Envelope Attack", ParameterKind::Float, 0.1f, 100.f, 0.1f, 0.4f, 5.f },
+	{ Param::EnvelopeRelease, "Envelope Release", ParameterKind::Float, 5.f, 1000.f, 1.f, 0.4f, 100.f },
+	{ Param::BandDynamics, "Band # Dynamics", ParameterKind::Float, -24.f, 24.f, 0.1f, 1.f, 0.f, maxBands },
+	{ Param::ModulationRate, "Modulation Rate", ParameterKind::Choice, 0.f, 0.f, 0.f, 1.f, 1.f, 1, nullptr, getModulationRateChoices },
+	{ Param::LfoRate, "LFO # Rate", ParameterKind::Float, 0.01f, 20.f, 0.01f, 0.3f, 1.f, numLfos },
+	{ Param::LfoShape, "LFO # Shape", ParameterKind::Choice, 0.f, 0.f, 0.f, 1.f, 0.f, numLfos, nullptr, getLfoShapeChoices },
+	{ Param::ModulationSource, "Mod # Source", ParameterKind::Choice, 0.f, 0.f, 0.f, 1.f, 0.f, numModulationSlots, nullptr, getModulationSourceChoices },
+	{ Param::ModulationTarget, "Mod # Target", ParameterKind::Choice, 0.f, 0.f, 0.f, 1.f, 0.f, numModulationSlots, nullptr, getModulationTargetChoices },
+	{ Param::ModulationDepth, "Mod # Depth", ParameterKind::Float, -100.f, 100.f, 1.f, 1.f, 0.f, numModulationSlots },
+	{ Param::Macro, "Macro #", ParameterKind::Float, 0.f, 100.f, 0.1f, 1.f, 0.f, numMacros },
+	{ Param::EnvelopeLink, "Envelope Link", ParameterKind::Choice, 0.f, 0.f, 0.f, 1.f, 0.f, 1, nullptr, getLinkChoices },
+} };
+
+constexpr const ParameterDescriptor& getDescriptor(Param param) noexcept { return parameterDescriptors[(size_t)param]; }
+
+constexpr bool areDescriptorsInOrder() noexcept
+{
+	for (size_t i = 0; i < parameterDescriptors.size(); ++i)
+		if ((size_t)parameterDescriptors[i].param != i)
+			return false;
+
+	return true;
+}
+
+static_assert(areDescriptorsInOrder(), "parameterDescriptors must list every Param in declaration order");
+
+constexpr int getNumParameterSlots() noexcept
+{
+	int slots = 0;
+
+	for (const auto& descriptor : parameterDescriptors)
+		slots += descriptor.count;
+
+	return slots;
+}
+
+/** One slot per actual parameter: its position in the processor's parameter list. */
+constexpr int numParameterSlots = getNumParameterSlots();
+
+/**
+	Where a Param's slots start and how far apart its numbered parameters are. A run
+	of adjacent families with the same count is laid out index by index (Band 1
+	Drive, Band 1 Mix, Band 1 Shape, Band 2 Drive...), as the layout always was.
+*/
+struct ParameterSlotLayout
+{
+	int first = 0, stride = 1;
+};
+
+constexpr std::array<ParameterSlotLayout, (size_t)Param::NumParams> makeParameterSlotLayouts() noexcept
+{
+	std::array<ParameterSlotLayout, (size_t)Param::NumParams> layouts{};
+	int slot = 0;
+
+	for (size_t first = 0; first < parameterDescriptors.size();)
+	{
+		const auto count = parameterDescriptors[first].count;
+		auto last = first + 1;
+
+		while (count > 1 && last < parameterDescriptors.size() && parameterDescriptors[last].count == count)
+			++last;
+
+		const auto stride = (int)(last - first);
+
+		for (auto i = first; i < last; ++i)
+			layouts[i] = { slot + (int)(i - first), stride };
+
+		slot += stride * count;
+		first = last;
+	}
+
+	return layouts;
+}
+
+inline constexpr auto parameterSlotLayouts = makeParameterSlotLayouts();
+
+constexpr int getParameterSlot(Param param, int index = 0) noexcept
+{
+	return parameterSlotLayouts[(size_t)param].first + index * parameterSlotLayouts[(size_t)param].stride;
+}
+
+/** Calls visit(descriptor, index) for every parameter, in slot order. */
+template <typename Visitor>
+void forEachParameter(Visitor&& visit)
+{
+	std::array<std::pair<Param, int>, (size_t)numParameterSlots> order{};
+
+	for (const auto& descriptor : parameterDescriptors)
+		for (int index = 0; index < descriptor.count; ++index)
+			order[(size_t)getParameterSlot(descriptor.param, index)] = { descriptor.param, index };
+
+	for (const auto& [param, index] : order)
+		visit(getDescriptor(param), index);
+}
+
+juce::String getParameterID(Param param, int index = 0);
+
+std::unique_ptr<juce::RangedAudioParameter> makeParameter(const ParameterDescriptor& descriptor, int index);
+
+//==============================================================================
+/**
+	Builds ChainSettings from any source of plain values: value(param, index)
+	returns the value of one slot. The one place a parameter's value is turned
+	into what the DSP uses.
+*/
+template <typename Values>
+ChainSettings makeChainSettings(const Values& value)
+{
+	ChainSettings settings;
+
+	settings.peakGainInDecibels = value(Param::PeakGain, 0);
+	settings.lowCutFreq = value(Param::LowCutFreq, 0);
+	settings.highCutFreq = value(Param::HighCutFreq, 0);
+	settings.lowCutSlope = (Slope)juce::jlimit(0, maxCutStages - 1, (int)value(Param::LowCutSlope, 0));
+	settings.highCutSlope = (Slope)juce::jlimit(0, maxCutStages - 1, (int)value(Param::HighCutSlope, 0));
+	settings.numBands = (int)value(Param::BandCount, 0);
+	settings.oversamplingStages = (int)value(Param::Oversampling, 0);
+	settings.linearPhaseOversampling = value(Param::OversamplingFilter, 0) >= 0.5f;
+	settings.antialiasingMode = (int)value(Param::Antialiasing, 0);
+	settings.parallelBands = value(Param::ParallelBands, 0) >= 0.5f;
+	settings.linearPhaseCrossover = value(Param::CrossoverMode, 0) >= 0.5f;
+	settings.crossoverPartitionOrder = minCrossoverPartitionOrder + (int)value(Param::CrossoverPartition, 0);
+	settings.rmsEnvelope = value(Param::EnvelopeDetector, 0) >= 0.5f;
+	settings.envelopeAttackMilliseconds = value(Param::EnvelopeAttack, 0);
+	settings.envelopeReleaseMilliseconds = value(Param::EnvelopeRelease, 0);
+	settings.envelopeLink = (int)value(Param::EnvelopeLink, 0);
+
+	for (int i = 0; i < maxBands - 1; ++i)
+		settings.crossoverFreqs[(size_t)i] = value(Param::CrossoverFreq, i);
+
+	for (int band = 0; band < maxBands; ++band)
+	{
+		settings.bandDriveInDecibels[(size_t)band] = value(Param::BandDrive, band);
+		settings.bandMix[(size_t)band] = value(Param::BandMix, band) * 0.01f;
+		settings.bandCurves[(size_t)band] = (int)value(Param::BandShape, band);
+		settings.bandDynamicsInDecibels[(size_t)band] = value(Param::BandDynamics, band);
+	}
+
+	settings.modulationInterval = 16 << juce::jlimit(0, 3, (int)value(Param::ModulationRate, 0));
+
+	for (int lfo = 0; lfo < numLfos; ++lfo)
+	{
+		settings.lfoRates[(size_t)lfo] = value(Param::LfoRate, lfo);
+		settings.lfoShapes[(size_t)lfo] = (int)value(Param::LfoShape, lfo);
+	}
+
+	for (int macro = 0; macro < numMacros; ++macro)
+		settings.macros[(size_t)macro] = value(Param::Macro, macro) * 0.01f;
+
+	for (int i = 0; i < numModulationSlots; ++i)
+	{
+		auto& slot = settings.modulationSlots[(size_t)i];
+		slot.source = (int)value(Param::ModulationSource, i);
+		slot.target = juce::jlimit(0, numModulationTargets - 1, (int)value(Param::ModulationTarget, i));
+		slot.depth = value(Param::ModulationDepth, i) * 0.01f;
+	}
+
+	return settings;
+}
+
+//==============================================================================
+/**
+	The parameters' value atomics, looked up by ID once at construction. Reading
+	is a plain atomic load, so it is safe and cheap on the audio thread.
+*/
+class ParameterValues
+{
+public:
+	explicit ParameterValues(juce::AudioProcessorValueTreeState& apvts);
+
+	float operator()(Param param, int index = 0) const noexcept
+	{
+		return values[(size_t)getParameterSlot(param, index)]->load(std::memory_order_relaxed);
+	}
+
+	ChainSettings getChainSettings() const noexcept { return makeChainSettings(*this); }
+
+private:
+	std::array<std::atomic<float>*, (size_t)numParameterSlots> values{};
+};
+
+//==============================================================================
+/**
+	Editor attachments for a parameter. Each checks that the control suits the
+	parameter's kind, and the combo box one fills in the parameter's choices.
+*/
+std::unique_ptr<juce::AudioProcessorValueTreeState::SliderAttachment> attachParameter(
+	juce::AudioProcessorValueTreeState& apvts, Param param, juce::Slider& slider, int index = 0);
+
+std::unique_ptr<juce::AudioProcessorValueTreeState::ComboBoxAttachment> attachParameter(
+	juce::AudioProcessorValueTreeState& apvts, Param param, juce::ComboBox& comboBox, int index = 0);
+
+std::unique_ptr<juce::AudioProcessorValueTreeState::ButtonAttachment> attachParameter(
+	juce::AudioProcessorValueTreeState& apvts, Param param, juce::Button& button, int index = 0);
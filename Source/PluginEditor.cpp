@@ -12,7 +12,10 @@
 //==============================================================================
 MultibandedDistortionPluginAudioProcessorEditor::MultibandedDistortionPluginAudioProcessorEditor(MultibandedDistortionPluginAudioProcessor& p)
 	: AudioProcessorEditor(&p), audioProcessor(p),
-	gainSliderAttachment(audioProcessor.apvts, "Peak Gain", gainSlider)
+	loadMeterDisplay(audioProcessor.getLoadMeter()),
+	spectrumDisplay(audioProcessor.getSpectrumAnalyzer()),
+	responseCurveDisplay(audioProcessor),
+	gainSliderAttachment(attachParameter(audioProcessor.apvts, Param::PeakGain, gainSlider))
 {
 	// Make sure that before the constructor has finished, you've set the
 	// editor's size to whatever you need it to be.
@@ -43,7 +46,10 @@ void MultibandedDistortionPluginAudioProcessorEditor::resized()
 	// This is generally where you'll want to lay out the positions of any
 	// subcomponents in your editor..
 	auto bounds = getLocalBounds();
+	loadMeterDisplay.setBounds(bounds.removeFromTop(20).reduced(4, 2));
 	auto responseArea = bounds.removeFromTop(bounds.getHeight() * 0.66);
+	spectrumDisplay.setBounds(responseArea.reduced(4));
+	responseCurveDisplay.setBounds(responseArea.reduced(4));
 
 	auto knobsArea = bounds.removeFromLeft(bounds.getWidth() * 0.142);
 	gainSlider.setBounds(knobsArea);
@@ -53,6 +59,298 @@ std::vector<juce::Component*> MultibandedDistortionPluginAudioProcessorEditor::g
 {
 	return
 	{
-	&gainSlider 
+	&gainSlider,
+	&loadMeterDisplay,
+	&spectrumDisplay,
+	&responseCurveDisplay
 	};
-}
\ No newline at end of file
+}
+
+//==============================================================================
+LoadMeterDisplay::LoadMeterDisplay(LoadMeter& meterToShow)
+	: meter(meterToShow)
+{
+	startTimerHz(10);
+}
+
+void LoadMeterDisplay::timerCallback()
+{
+	shown = meter.takeSnapshot();
+
+	// Hold the peak and let it fall back slowly, so short spikes stay readable.
+	heldPeak = juce::jmax(shown.peakLoad, heldPeak * 0.9f);
+	repaint();
+}
+
+void LoadMeterDisplay::paint(juce::Graphics& g)
+{
+	auto bounds = getLocalBounds().toFloat();
+
+	g.setColour(juce::Colours::black.withAlpha(0.4f));
+	g.fillRect(bounds);
+
+	const auto colour = heldPeak >= 1.f ? juce::Colours::red
+		: heldPeak >= LoadMeter::nearMissThreshold ? juce::Colours::orange
+		: juce::Colours::limegreen;
+
+	g.setColour(colour.withAlpha(0.6f));
+	g.fillRect(bounds.withWidth(bounds.getWidth() * juce::jlimit(0.f, 1.f, shown.averageLoad)));
+
+	g.setColour(colour);
+	g.fillRect(bounds.getX() + bounds.getWidth() * juce::jlimit(0.f, 1.f, heldPeak) - 1.f, bounds.getY(), 2.f, bounds.getHeight());
+
+	juce::String text;
+	text << "CPU " << juce::String(shown.averageLoad * 100.f, 1) << "%  peak " << juce::String(heldPeak * 100.f, 1)
+		<< "%  near misses " << shown.nearMisses << "  overruns " << shown.overruns;
+
+	g.setColour(juce::Colours::white);
+	g.setFont(12.0f);
+	g.drawText(text, getLocalBounds().reduced(4, 0), juce::Justification::centredLeft);
+}
+//==============================================================================
+SpectrumDisplay::SpectrumDisplay(SpectrumAnalyzer& analyzerToShow)
+	: analyzer(analyzerToShow)
+{
+	analyzer.start();
+	startTimerHz(juce::roundToInt(analyzer.getFrameRate()));
+}
+
+SpectrumDisplay::~SpectrumDisplay()
+{
+	analyzer.stop();
+}
+
+void SpectrumDisplay::timerCallback()
+{
+	const auto frame = analyzer.getFrameCount();
+
+	if (frame != lastFrame)
+	{
+		lastFrame = frame;
+		repaint();
+	}
+}
+
+void SpectrumDisplay::mouseDown(const juce::MouseEvent& event)
+{
+	if (!event.mods.isPopupMenu())
+		return;
+
+	juce::PopupMenu fftSizes, frameRates;
+
+	for (int order = SpectrumAnalyzer::minimumFFTOrder; order <= SpectrumAnalyzer::maximumFFTOrder; ++order)
+		fftSizes.addItem(juce::String(1 << order), true, analyzer.getFFTOrder() == order, [this, order] { analyzer.setFFTOrder(order); });
+
+	for (auto rate : { 15, 30, 60 })
+	{
+		frameRates.addItem(juce::String(rate) + " fps", true, juce::roundToInt(analyzer.getFrameRate()) == rate, [this, rate]
+		{
+			analyzer.setFrameRate(rate);
+			startTimerHz(rate);
+		});
+	}
+
+	juce::PopupMenu menu;
+	menu.addSubMenu("FFT Size", fftSizes);
+	menu.addSubMenu("Frame Rate", frameRates);
+	menu.showMenuAsync(juce::PopupMenu::Options().withTargetComponent(this));
+}
+
+void SpectrumDisplay::paint(juce::Graphics& g)
+{
+	auto bounds = getLocalBounds().toFloat();
+
+	g.setColour(juce::Colours::black.withAlpha(0.4f));
+	g.fillRect(bounds);
+
+	g.setColour(juce::Colours::white.withAlpha(0.1f));
+
+	for (auto frequency : { 100.f, 1000.f, 10000.f })
+	{
+		const auto x = bounds.getX() + bounds.getWidth() * analyzer.frequencyToProportion(frequency);
+		g.drawVerticalLine(juce::roundToInt(x), bounds.getY(), bounds.getBottom());
+	}
+
+	for (auto decibels : { 0.f, -24.f, -48.f, -72.f })
+	{
+		const auto y = juce::jmap(decibels, SpectrumAnalyzer::minimumDecibels, SpectrumAnalyzer::maximumDecibels, bounds.getBottom(), bounds.getY());
+		g.drawHorizontalLine(juce::roundToInt(y), bounds.getX(), bounds.getRight());
+	}
+
+	// The analyser builds the paths in unit coordinates; all that is left is to scale them.
+	const auto toBounds = juce::AffineTransform::scale(bounds.getWidth(), bounds.getHeight()).translated(bounds.getX(), bounds.getY());
+
+	g.setColour(juce::Colours::lightgrey.withAlpha(0.5f));
+	g.strokePath(analyzer.getPath(SpectrumAnalyzer::Tap::Pre), juce::PathStrokeType(1.f), toBounds);
+
+	g.setColour(juce::Colours::orange);
+	g.strokePath(analyzer.getPath(SpectrumAnalyzer::Tap::Post), juce::PathStrokeType(1.5f), toBounds);
+}
+
+//==============================================================================
+ResponseCurveDisplay::ResponseCurveDisplay(MultibandedDistortionPluginAudioProcessor& processorToShow)
+	: processor(processorToShow), parameterValues(processorToShow.apvts)
+{
+	// Clicks go through to the spectrum underneath.
+	setInterceptsMouseClicks(false, false);
+
+	for (auto* parameter : processor.getParameters())
+		parameter->addListener(this);
+
+	startTimerHz(30);
+}
+
+ResponseCurveDisplay::~ResponseCurveDisplay()
+{
+	for (auto* parameter : processor.getParameters())
+		parameter->removeListener(this);
+}
+
+void ResponseCurveDisplay::parameterValueChanged(int, float)
+{
+	// May be called on the audio thread.
+	parametersChanged.store(true, std::memory_order_release);
+}
+
+void ResponseCurveDisplay::timerCallback()
+{
+	if (processor.getSampleRate() != sampleRate)
+	{
+		updateFrequencies();
+		rebuild();
+	}
+	else if (parametersChanged.exchange(false, std::memory_order_acquire))
+	{
+		rebuild();
+	}
+}
+
+void ResponseCurveDisplay::resized()
+{
+	updateFrequencies();
+	rebuild();
+}
+
+void ResponseCurveDisplay::updateFrequencies()
+{
+	sampleRate = processor.getSampleRate();
+
+	const auto fs = sampleRate > 0.0 ? sampleRate : 44100.0;
+	const auto nyquist = fs * 0.5;
+	const auto numColumns = (size_t)juce::jmax(2, getWidth());
+
+	frequencies.resize(numColumns);
+	warped.resize(numColumns);
+	chainMagnitudes.resize(numColumns);
+	bandMagnitudes.resize(numColumns);
+
+	for (size_t x = 0; x < numColumns; ++x)
+	{
+		frequencies[x] = 20.0 * std::pow(nyquist / 20.0, (double)x / (double)(numColumns - 1));
+		warped[x] = std::tan(juce::MathConstants<double>::pi * juce::jmin(frequencies[x], fs * 0.49) / fs);
+	}
+}
+
+void ResponseCurveDisplay::rebuild()
+{
+	parametersChanged.store(false, std::memory_order_relaxed);
+
+	const auto fs = sampleRate > 0.0 ? sampleRate : 44100.0;
+	const auto settings = parameterValues.getChainSettings();
+	const auto numColumns = frequencies.size();
+
+	auto peak = juce::dsp::IIR::Coefficients<double>::makePeakFilter(fs, (double)settings.peakFreq, (double)settings.peakQuality,
+		juce::Decibels::decibelsToGain((double)settings.peakGainInDecibels));
+	peak->getMagnitudeForFrequencyArray(frequencies.data(), chainMagnitudes.data(), numColumns, fs);
+
+	// The same sections the engine builds, one pass per running stage; bandMagnitudes is free until the bands below.
+	auto addCut = [&](double frequency, Slope slope, bool highPass, int numStages)
+	{
+		CoefficientEngine::CutCoefficients sections;
+		CoefficientEngine::makeCutCoefficients(sections, fs, frequency, slope, highPass);
+
+		for (int stage = 0; stage < numStages; ++stage)
+		{
+			const juce::dsp::IIR::Coefficients<double> section(sections[(size_t)stage]);
+			section.getMagnitudeForFrequencyArray(frequencies.data(), bandMagnitudes.data(), numColumns, fs);
+
+			for (size_t x = 0; x < numColumns; ++x)
+				chainMagnitudes[x] *= bandMagnitudes[x];
+		}
+	};
+
+	// A cut at the end of its range is switched off, exactly as the processor treats it.
+	addCut((double)settings.lowCutFreq, settings.lowCutSlope, true, getNumLowCutStages(settings));
+	addCut((double)settings.highCutFreq, settings.highCutSlope, false, getNumHighCutStages(settings));
+	buildPath(chainPath, chainMagnitudes);
+
+	// Crossover frequencies are clamped the way MultibandCrossover does it.
+	std::array<double, maxBands - 1> cutoffs{};
+	numBandPaths = juce::jlimit(2, maxBands, settings.numBands);
+
+	for (size_t c = 0; c < (size_t)numBandPaths - 1; ++c)
+	{
+		auto frequency = (double)settings.crossoverFreqs[c];
+
+		if (c > 0)
+			frequency = juce::jmax(frequency, cutoffs[c - 1]);
+
+		cutoffs[c] = juce::jlimit(10.0, fs * 0.45, frequency);
+	}
+
+	// A band is the high output of every crossover below it and the low output of its own.
+	// An LR4 section's low output is 1 / (1 + r^4) and its high output r^4 / (1 + r^4), with r the
+	// ratio of warped frequencies; the compensating allpasses leave magnitudes alone.
+	for (int band = 0; band < numBandPaths; ++band)
+	{
+		std::fill(bandMagnitudes.begin(), bandMagnitudes.end(), 1.0);
+
+		for (int c = 0; c <= juce::jmin(band, numBandPaths - 2); ++c)
+		{
+			const auto inverseCutoff = 1.0 / std::tan(juce::MathConstants<double>::pi * cutoffs[(size_t)c] / fs);
+			const auto isLowOutput = c == band;
+
+			for (size_t x = 0; x < numColumns; ++x)
+			{
+				const auto r = warped[x] * inverseCutoff;
+				const auto r4 = r * r * r * r;
+				bandMagnitudes[x] *= (isLowOutput ? 1.0 : r4) / (1.0 + r4);
+			}
+		}
+
+		buildPath(bandPaths[(size_t)band], bandMagnitudes);
+	}
+
+	repaint();
+}
+
+void ResponseCurveDisplay::buildPath(juce::Path& path, const std::vector<double>& magnitudes) const
+{
+	const auto height = (double)getHeight();
+
+	path.clear();
+	path.preallocateSpace((int)magnitudes.size() * 3);
+
+	for (size_t x = 0; x < magnitudes.size(); ++x)
+	{
+		const auto decibels = juce::Decibels::gainToDecibels(magnitudes[x], -rangeInDecibels * 2.0);
+		const auto y = (float)juce::jmap(juce::jlimit(-rangeInDecibels, rangeInDecibels, decibels), -rangeInDecibels, rangeInDecibels, height, 0.0);
+
+		if (x == 0)
+			path.startNewSubPath((float)x, y);
+		else
+			path.lineTo((float)x, y);
+	}
+}
+
+void ResponseCurveDisplay::paint(juce::Graphics& g)
+{
+	for (int band = 0; band < numBandPaths; ++band)
+	{
+		g.setColour(juce::Colour::fromHSV((float)band / (float)maxBands, 0.5f, 0.9f, 0.5f));
+		g.strokePath(bandPaths[(size_t)band], juce::PathStrokeType(1.f));
+	}
+
+	g.setColour(juce::Colours::white);
+	g.strokePath(chainPath, juce::PathStrokeType(2.f));
+}
@@ -17,6 +17,78 @@ struct CustomRotarySlider : juce::Slider
 
 	}
 };
+
+/** The processor's CPU load and deadline counts, refreshed ten times a second. */
+struct LoadMeterDisplay : juce::Component, private juce::Timer
+{
+	explicit LoadMeterDisplay(LoadMeter& meterToShow);
+
+	void paint(juce::Graphics& g) override;
+
+private:
+	void timerCallback() override;
+
+	LoadMeter& meter;
+	LoadMeter::Snapshot shown;
+	float heldPeak = 0.f;
+};
+
+/**
+	Input and output spectra. Keeps the analyser running for as long as it is on
+	screen; right-click to change the FFT size and frame rate.
+*/
+struct SpectrumDisplay : juce::Component, private juce::Timer
+{
+	explicit SpectrumDisplay(SpectrumAnalyzer& analyzerToShow);
+	~SpectrumDisplay() override;
+
+	void paint(juce::Graphics& g) override;
+	void mouseDown(const juce::MouseEvent& event) override;
+
+private:
+	void timerCallback() override;
+
+	SpectrumAnalyzer& analyzer;
+	int lastFrame = -1;
+};
+
+/**
+	Magnitude response of the filter chain and of each crossover band, on the
+	same frequency axis as the spectrum. Parameter changes only raise a flag;
+	the curves are evaluated for every pixel column in one pass and cached as
+	paths when the flag, the sample rate or the size changes, so paint() only
+	strokes them.
+*/
+struct ResponseCurveDisplay : juce::Component, private juce::AudioProcessorParameter::Listener, private juce::Timer
+{
+	explicit ResponseCurveDisplay(MultibandedDistortionPluginAudioProcessor& processorToShow);
+	~ResponseCurveDisplay() override;
+
+	void paint(juce::Graphics& g) override;
+	void resized() override;
+
+	static constexpr double rangeInDecibels = 24.0;
+
+private:
+	void parameterValueChanged(int parameterIndex, float newValue) override;
+	void parameterGestureChanged(int, bool) override {}
+	void timerCallback() override;
+
+	void updateFrequencies();
+	void rebuild();
+	void buildPath(juce::Path& path, const std::vector<double>& magnitudes) const;
+
+	MultibandedDistortionPluginAudioProcessor& processor;
+	ParameterValues parameterValues;
+	std::atomic<bool> parametersChanged{ true };
+	double sampleRate = 0.0;
+
+	// One entry per pixel column; warped holds tan(pi f / fs) for the bilinear-transformed crossovers.
+	std::vector<double> frequencies, warped, chainMagnitudes, bandMagnitudes;
+	juce::Path chainPath;
+	std::array<juce::Path, maxBands> bandPaths;
+	int numBandPaths = 0;
+};
 //==============================================================================
 /**
 */
@@ -37,10 +109,13 @@ private:
 
 	CustomRotarySlider
 		gainSlider;
+	LoadMeterDisplay loadMeterDisplay;
+	SpectrumDisplay spectrumDisplay;
+	ResponseCurveDisplay responseCurveDisplay;
 
 	using APVTS = juce::AudioProcessorValueTreeState;
 	using Attachment = APVTS::SliderAttachment;
-	Attachment gainSliderAttachment;
+	std::unique_ptr<Attachment> gainSliderAttachment;
 	std::vector<juce::Component*> getComps();
 	JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(MultibandedDistortionPluginAudioProcessorEditor)
 };
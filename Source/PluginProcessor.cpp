@@ -22,6 +22,8 @@ MultibandedDistortionPluginAudioProcessor::MultibandedDistortionPluginAudioProce
 	)
 #endif
 {
+	// Without a library the bank keeps its single program of default values.
+	presetBank.loadFrom(PresetBank::getDefaultLibraryFile());
 }
 
 MultibandedDistortionPluginAudioProcessor::~MultibandedDistortionPluginAudioProcessor()
@@ -63,31 +65,77 @@ bool MultibandedDistortionPluginAudioProcessor::isMidiEffect() const
 
 double MultibandedDistortionPluginAudioProcessor::getTailLengthSeconds() const
 {
-	return 0.0;
+	const auto sampleRate = getSampleRate();
+	return sampleRate > 0.0 ? tailSamples.load() / sampleRate : 0.0;
+}
+
+void MultibandedDistortionPluginAudioProcessor::updateTail() noexcept
+{
+	tailSamples.store(juce::roundToInt(coefficientEngine.getTailInSamples()) + pendingLatency.load(std::memory_order_relaxed),
+		std::memory_order_relaxed);
 }
 
 int MultibandedDistortionPluginAudioProcessor::getNumPrograms()
 {
-	return 1;   // NB: some hosts don't cope very well if you tell them there are 0 programs,
-	// so this should be at least 1, even if you're not really implementing programs.
+	// The bank always holds at least the default program.
+	return presetBank.size();
 }
 
 int MultibandedDistortionPluginAudioProcessor::getCurrentProgram()
 {
-	return 0;
+	return currentProgram.load();
 }
 
 void MultibandedDistortionPluginAudioProcessor::setCurrentProgram(int index)
 {
+	if (!juce::isPositiveAndBelow(index, presetBank.size()))
+		return;
+
+	currentProgram = index;
+
+	// With no audio running there is nothing to fade, so the parameters move straight away.
+	if (!prepared.load())
+	{
+		presetBank.applyToParameters(index);
+		return;
+	}
+
+	pendingProgram.store(index, std::memory_order_release);
 }
 
 const juce::String MultibandedDistortionPluginAudioProcessor::getProgramName(int index)
 {
-	return {};
+	return juce::isPositiveAndBelow(index, presetBank.size()) ? presetBank[index].name : juce::String();
 }
 
 void MultibandedDistortionPluginAudioProcessor::changeProgramName(int index, const juce::String& newName)
 {
+	if (juce::isPositiveAndBelow(index, presetBank.size()))
+		presetBank.setName(index, newName);
+}
+
+juce::String MultibandedDistortionPluginAudioProcessor::loadProgramLibrary(const juce::File& file)
+{
+	PresetBank bank(*this);
+	const auto error = bank.loadFrom(file);
+
+	if (error.isNotEmpty())
+		return error;
+
+	if (getSampleRate() > 0.0)
+		bank.prepare(getSampleRate());
+
+	{
+		// Only the swap waits for the audio callback; decoding and preparing happened above.
+		const juce::ScopedLock lock(getCallbackLock());
+		presetBank.swapWith(bank);
+		pendingProgram = -1;
+		programTarget = -1;
+		currentProgram = 0;
+	}
+
+	updateHostDisplay(juce::AudioProcessorListener::ChangeDetails().withProgramChanged(true));
+	return {};
 }
 
 //==============================================================================
@@ -95,21 +143,123 @@ void MultibandedDistortionPluginAudioProcessor::prepareToPlay(double sampleRate,
 {
 	// Use this method as the place to do any pre-playback
 	// initialisation that you need..
-	juce::dsp::ProcessSpec spec;
-	spec.maximumBlockSize = samplesPerBlock;
-	spec.numChannels = 1;
-	spec.sampleRate = sampleRate;
-	leftChain.prepare(spec);
-	rightChain.prepare(spec);
+	coefficientEngine.prepare(sampleRate);
+	coefficientEngine.advance(0);
+
+	const auto& settings = coefficientEngine.getChainSettings();
+	linearPhaseKernels.request(settings.numBands, settings.crossoverFreqs, settings.crossoverPartitionOrder);
+	linearPhaseKernels.prepare(sampleRate);
+	modulationEngine.prepare(sampleRate, samplesPerBlock);
+	maximumSegmentSamples = samplesPerBlock;
+	linkedLevels.setSize(maxBands, samplesPerBlock);
+
+	// Only the precision the host asked for gets any state.
+	const auto numGroups = isUsingDoublePrecision() ? prepareChannelGroups<double>(sampleRate, samplesPerBlock)
+		: prepareChannelGroups<float>(sampleRate, samplesPerBlock);
+
+	bandTraceEvents.resize((size_t)numGroups * maxBands);
+
+	// One band always stays on the audio thread, so there is no use for more
+	// workers than bands minus one.
+	workerPool.prepare(juce::jmin(numGroups * maxBands - 1, juce::SystemStats::getNumCpus() - 1), samplesPerBlock, sampleRate);
+	workerPool.setEnabled(parallelBands->load() >= 0.5f);
+
+	pendingLatency = juce::roundToInt(getLatencyOfBands());
+	setLatencySamples(pendingLatency.load());
+	startTimerHz(20);
+
+	chainFadeSamples = juce::jmax(1, juce::roundToInt(sampleRate * chainFadeSeconds));
+	chainLevel = coefficientEngine.isNeutral() ? 0.f : 1.f;
+	silentSamples = 0;
+	asleep = false;
+	updateTail();
+
+	presetBank.prepare(sampleRate);
+	programFadeSamples = juce::jmax(1, juce::roundToInt(sampleRate * programFadeSeconds));
+	programLevel = 1.f;
+	programTarget = -1;
+	prepared = true;
+
+	loadMeter.prepare(sampleRate);
+	spectrumAnalyzer.prepare(sampleRate);
+
+	if (DspTrace::isEnabled())
+	{
+		traceRecorder.prepare(sampleRate);
+
+		if (traceWriter == nullptr)
+		{
+			const auto file = traceFile != juce::File() ? traceFile
+				: juce::File::getSpecialLocation(juce::File::tempDirectory)
+					.getNonexistentChildFile("MultibandedDistortionPlugin_trace", ".json");
+			traceWriter = std::make_unique<DspTrace::Writer>(traceRecorder, file);
+		}
+	}
+}
+
+template <typename SampleType>
+int MultibandedDistortionPluginAudioProcessor::prepareChannelGroups(double sampleRate, int samplesPerBlock)
+{
+	auto& groups = getChannelGroups<SampleType>();
+	using Group = ChannelGroup<SampleType>;
+
+	// One group per SIMD register's worth of channels, rebuilt only when the
+	// layout needs a different number of them.
+	const auto numChannels = juce::jmax(getTotalNumInputChannels(), getTotalNumOutputChannels());
+	const auto numGroups = juce::jmax(1, (numChannels + (int)Group::numLanes - 1) / (int)Group::numLanes);
 
-	auto chainSettings = getChainSettings(apvts);
-	updatePeakFilter(chainSettings);
+	if (groups.size() != numGroups)
+	{
+		groups.clear();
+
+		for (int i = 0; i < numGroups; ++i)
+			groups.add(new Group((size_t)i * Group::numLanes));
+	}
+
+	getChannelGroups<std::conditional_t<std::is_same_v<SampleType, float>, double, float>>().clear();
+
+	for (auto* group : groups)
+	{
+		updateBandSettings(*group, coefficientEngine.getChainSettings());
+		group->prepare(sampleRate, samplesPerBlock);
+	}
+
+	updateFilters();
+
+	// The filters size their state from the coefficient order, so reset once the
+	// real coefficients are in rather than letting the first processBlock do it.
+	for (auto* group : groups)
+	{
+		group->chain.reset();
+		group->setCutStages(coefficientEngine.getChainSettings());
+	}
+
+	return numGroups;
+}
+
+double MultibandedDistortionPluginAudioProcessor::getLatencyOfBands() const noexcept
+{
+	const auto crossoverLatency = coefficientEngine.getChainSettings().linearPhaseCrossover
+		? (double)linearPhaseKernels.getLatencyInSamples() : 0.0;
+
+	if (auto* group = doubleGroups.getFirst())
+		return crossoverLatency + group->bands[0].getLatencyInSamples();
+
+	if (auto* group = floatGroups.getFirst())
+		return crossoverLatency + group->bands[0].getLatencyInSamples();
+
+	return crossoverLatency;
 }
 
 void MultibandedDistortionPluginAudioProcessor::releaseResources()
 {
 	// When playback stops, you can use this as an opportunity to free up any
 	// spare memory, etc.
+	prepared = false;
+	workerPool.stop();
+	linearPhaseKernels.release();
+	stopTimer();
+	traceWriter.reset();
 }
 
 #ifndef JucePlugin_PreferredChannelConfigurations
@@ -119,12 +269,9 @@ bool MultibandedDistortionPluginAudioProcessor::isBusesLayoutSupported(const Bus
 	juce::ignoreUnused(layouts);
 	return true;
 #else
-	// This is the place where you check if the layout is supported.
-	// In this template code we only support mono or stereo.
-	// Some plugin hosts, such as certain GarageBand versions, will only
-	// load plugins that support stereo bus layouts.
-	if (layouts.getMainOutputChannelSet() != juce::AudioChannelSet::mono()
-		&& layouts.getMainOutputChannelSet() != juce::AudioChannelSet::stereo())
+	// Channels are processed in SIMD-width groups, so any layout will do,
+	// from mono up to immersive formats.
+	if (layouts.getMainOutputChannelSet().isDisabled())
 		return false;
 
 	// This checks if the input layout matches the output layout
@@ -139,8 +286,26 @@ bool MultibandedDistortionPluginAudioProcessor::isBusesLayoutSupported(const Bus
 #endif
 
 void MultibandedDistortionPluginAudioProcessor::processBlock(juce::AudioBuffer<float>& buffer, juce::MidiBuffer& midiMessages)
+{
+	process(buffer, midiMessages);
+}
+
+void MultibandedDistortionPluginAudioProcessor::processBlock(juce::AudioBuffer<double>& buffer, juce::MidiBuffer& midiMessages)
+{
+	process(buffer, midiMessages);
+}
+
+template <typename SampleType>
+void MultibandedDistortionPluginAudioProcessor::process(juce::AudioBuffer<SampleType>& buffer, juce::MidiBuffer& midiMessages)
 {
 	juce::ScopedNoDenormals noDenormals;
+	const RealtimeSafety::ScopedAudioThread audioThread;
+	const LoadMeter::ScopedMeasurement loadMeasurement(loadMeter, buffer.getNumSamples());
+
+	if constexpr (DspTrace::isEnabled())
+		traceRecorder.beginBlock();
+
+	MULTIBAND_TRACE_SCOPE(traceRecorder, DspTrace::Stage::ProcessBlock, -1, buffer.getNumSamples());
 	auto totalNumInputChannels = getTotalNumInputChannels();
 	auto totalNumOutputChannels = getTotalNumOutputChannels();
 
@@ -153,19 +318,454 @@ void MultibandedDistortionPluginAudioProcessor::processBlock(juce::AudioBuffer<f
 	for (auto i = totalNumInputChannels; i < totalNumOutputChannels; ++i)
 		buffer.clear(i, 0, buffer.getNumSamples());
 
+	spectrumAnalyzer.push(SpectrumAnalyzer::Tap::Pre, buffer);
 
-	auto chainSettings = getChainSettings(apvts);
+	// Mapped controllers split the block where they arrive, and modulated crossovers
+	// at every control tick; otherwise it is one segment.
+	eventScheduler.process(midiMessages, buffer.getNumSamples(), coefficientEngine, [this, &buffer](int start, int length)
+	{
+		// Hosts may send more than they asked to prepare for; nothing past here is sized for that.
+		// Unprepared, there are no groups to overrun and the audio only passes through.
+		const auto limit = maximumSegmentSamples > 0 ? maximumSegmentSamples : length;
+
+		if (length == buffer.getNumSamples() && length <= limit && !splitsAtTicks())
+		{
+			processSegment(buffer);
+			return;
+		}
+
+		for (const auto end = start + length; start < end;)
+		{
+			auto piece = juce::jmin(end - start, limit);
+
+			if (splitsAtTicks())
+				piece = juce::jmin(piece, modulationEngine.getSamplesUntilTick());
+
+			juce::AudioBuffer<SampleType> segment(buffer.getArrayOfWritePointers(), buffer.getNumChannels(), start, piece);
+			processSegment(segment);
+			start += piece;
+		}
+	});
+
+	spectrumAnalyzer.push(SpectrumAnalyzer::Tap::Post, buffer);
+}
 
-	updatePeakFilter(chainSettings);
+template <typename SampleType>
+void MultibandedDistortionPluginAudioProcessor::processSegment(juce::AudioBuffer<SampleType>& buffer)
+{
+	const auto settingsChanged = coefficientEngine.beginBlock();
 
+	auto& channelGroups = getChannelGroups<SampleType>();
+	using Group = ChannelGroup<SampleType>;
+	juce::dsp::AudioBlock<SampleType> block(buffer);
+	const auto numSamples = block.getNumSamples();
+	const auto silenceThreshold = (SampleType)CoefficientEngine::tailThreshold;
+
+	if (programTarget < 0)
+		programTarget = pendingProgram.exchange(-1, std::memory_order_acquire);
+
+	// A sleeping processor has nothing to fade, so it switches at once.
+	if (programTarget >= 0 && (programLevel == 0.f || asleep))
+	{
+		applyProgram<SampleType>(programTarget);
+		programTarget = -1;
+	}
+
+	if (syncedGeneration.load(std::memory_order_acquire) == appliedGeneration.load(std::memory_order_relaxed))
+		coefficientEngine.releaseSnapshot();
+
+	const auto programStart = programLevel;
+	const auto programStep = (float)numSamples / (float)programFadeSamples;
+	programLevel = programTarget >= 0 ? juce::jmax(0.f, programLevel - programStep) : juce::jmin(1.f, programLevel + programStep);
+
+	// Silence is counted on the bus itself, so a sleeping processor doesn't even interleave.
+	if (buffer.getMagnitude(0, (int)numSamples) > silenceThreshold)
+	{
+		silentSamples = 0;
+		asleep = false;
+	}
+	else
+	{
+		silentSamples += (juce::int64)numSamples;
+	}
+
+	// The modulators keep time through sleep too, so the LFOs don't stall.
+	modulationEngine.process(coefficientEngine.getChainSettings(), (int)numSamples);
+
+	if (!modulationEngine.modulatesPeak())
+		coefficientEngine.setPeakModulation({});
+
+	if (asleep)
+	{
+		// Keep the settings moving, so waking up doesn't start from stale ones.
+		if (modulationEngine.modulatesPeak() && modulationEngine.getNumTicks() > 0)
+			coefficientEngine.setPeakModulation(modulationEngine.getPeakModulation(modulationEngine.getNumTicks() - 1));
+
+		if (coefficientEngine.advance((int)numSamples) || settingsChanged)
+		{
+			for (auto* group : channelGroups)
+				group->setCutStages(coefficientEngine.getChainSettings());
+
+			updateFilters();
+			updateTail();
+		}
+
+		buffer.clear();
+		return;
+	}
+
+	// Groups past the buffer's last channel have nothing to do this block; with no
+	// groups at all (not prepared for this precision) the audio passes through.
+	const auto numActiveGroups = juce::jmin(channelGroups.size(), ((int)block.getNumChannels() + (int)Group::numLanes - 1) / (int)Group::numLanes);
+
+	for (int i = 0; i < numActiveGroups; ++i)
+		channelGroups.getUnchecked(i)->interleave(block);
+
+	// At unity gain the chain is skipped altogether, fading over chainFadeSamples
+	// on the way out and back in.
+	const auto startLevel = chainLevel;
+	const auto fadeStep = (float)numSamples / (float)chainFadeSamples;
+	chainLevel = coefficientEngine.isNeutral() ? juce::jmax(0.f, chainLevel - fadeStep) : juce::jmin(1.f, chainLevel + fadeStep);
+
+	const auto runChain = startLevel > 0.f || chainLevel > 0.f;
+	const auto fading = runChain && (startLevel < 1.f || chainLevel < 1.f);
+
+	// Whatever the filters held from before they were skipped is stale.
+	if (startLevel == 0.f && chainLevel > 0.f)
+		for (auto* group : channelGroups)
+			group->chain.reset();
+
+	if (fading)
+		for (int i = 0; i < numActiveGroups; ++i)
+			channelGroups.getUnchecked(i)->storeDry(numSamples);
+
+	// While a parameter is ramping the coefficients are re-derived every few samples,
+	// and while the peak is modulated on every control tick; otherwise the whole
+	// block is a single segment.
+	auto rebuiltAny = false;
+	const auto interval = coefficientEngine.isRamping() ? (size_t)coefficientEngine.getRampInterval() : numSamples;
+	const auto interpolate = coefficientEngine.getRampMode() == CoefficientEngine::RampMode::PerSample;
+	const auto numTicks = modulationEngine.modulatesPeak() ? modulationEngine.getNumTicks() : 0;
+	auto tick = 0;
+
+	for (size_t start = 0, length = 0; start < numSamples; start += length)
+	{
+		length = juce::jmin(interval, numSamples - start);
 
-	juce::dsp::AudioBlock<float> block(buffer);
-	auto leftBlock = block.getSingleChannelBlock(0);
-	auto rightBlock = block.getSingleChannelBlock(1);
-	juce::dsp::ProcessContextReplacing<float> leftContext(leftBlock);
-	juce::dsp::ProcessContextReplacing<float> rightContext(rightBlock);
-	leftChain.process(leftContext);
-	rightChain.process(rightContext);
+		if (tick < numTicks && (size_t)modulationEngine.getTickPosition(tick) == start)
+			coefficientEngine.setPeakModulation(modulationEngine.getPeakModulation(tick++));
+
+		if (tick < numTicks)
+			length = juce::jmin(length, (size_t)modulationEngine.getTickPosition(tick) - start);
+
+		const auto rebuilt = coefficientEngine.advance((int)length);
+
+		if (rebuilt)
+		{
+			rebuiltAny = true;
+
+			for (auto* group : channelGroups)
+				group->setCutStages(coefficientEngine.getChainSettings());
+
+			if (!interpolate || !runChain)
+				updateFilters();
+		}
+
+		if (!runChain)
+			continue;
+
+		for (int i = 0; i < numActiveGroups; ++i)
+		{
+			auto& group = *channelGroups.getUnchecked(i);
+			auto segment = group.block.getSubBlock(start, length);
+
+			if (rebuilt && interpolate)
+				processChainInterpolated(group, segment);
+			else
+				processChain(group, segment);
+		}
+	}
+
+	if (fading)
+		for (int i = 0; i < numActiveGroups; ++i)
+			channelGroups.getUnchecked(i)->crossfadeWithDry(numSamples, (SampleType)startLevel, (SampleType)chainLevel);
+
+	// A segment with modulated crossovers starts on a tick, so it splits at that tick's frequencies.
+	auto bandSettings = coefficientEngine.getChainSettings();
+
+	if (splitsAtTicks())
+		modulationEngine.modulateCrossovers(bandSettings.crossoverFreqs);
+
+	for (int i = 0; i < numActiveGroups; ++i)
+	{
+		auto& group = *channelGroups.getUnchecked(i);
+		updateBandSettings(group, bandSettings);
+
+		for (size_t band = 0; band < group.bands.size(); ++band)
+			group.bands[band].setModulation(modulationEngine.getDriveModulation(band), modulationEngine.getMixModulation(band));
+	}
+
+	if (numActiveGroups > 0)
+	{
+		processBands<SampleType>(numActiveGroups, (int)numSamples, coefficientEngine.getChainSettings());
+		pendingLatency.store(juce::roundToInt(getLatencyOfBands()), std::memory_order_relaxed);
+	}
+
+	for (int i = 0; i < numActiveGroups; ++i)
+		channelGroups.getUnchecked(i)->deinterleave(block);
+
+	if (settingsChanged || rebuiltAny)
+		updateTail();
+
+	if (programStart < 1.f || programLevel < 1.f)
+		buffer.applyGainRamp(0, (int)numSamples, (SampleType)programStart, (SampleType)programLevel);
+
+	// The output is only measured once the input has been quiet for longer than the tail.
+	if (silentSamples > tailSamples.load(std::memory_order_relaxed) && buffer.getMagnitude(0, (int)numSamples) <= silenceThreshold)
+		asleep = true;
+}
+
+template <typename SampleType>
+void MultibandedDistortionPluginAudioProcessor::applyProgram(int index)
+{
+	if (!juce::isPositiveAndBelow(index, presetBank.size()))
+		return;
+
+	coefficientEngine.applySnapshot(presetBank[index].snapshot);
+	const auto& settings = coefficientEngine.getChainSettings();
+	auto& channelGroups = getChannelGroups<SampleType>();
+
+	for (auto* group : channelGroups)
+	{
+		updateBandSettings(*group, settings);
+		group->setCutStages(settings);
+	}
+
+	updateFilters();
+
+	// Nothing of the old program may ring on into the new one.
+	for (auto* group : channelGroups)
+		group->reset();
+
+	chainLevel = coefficientEngine.isNeutral() ? 0.f : 1.f;
+	updateTail();
+
+	appliedProgram.store(index, std::memory_order_relaxed);
+	appliedGeneration.fetch_add(1, std::memory_order_release);
+}
+
+template <typename SampleType>
+void MultibandedDistortionPluginAudioProcessor::updateBandSettings(ChannelGroup<SampleType>& group, const ChainSettings& chainSettings)
+{
+	auto& crossover = group.crossover;
+	auto& bands = group.bands;
+
+	crossover.setNumBands(chainSettings.numBands);
+
+	for (size_t i = 0; i < chainSettings.crossoverFreqs.size(); ++i)
+		crossover.setCrossoverFrequency(i, chainSettings.crossoverFreqs[i]);
+
+	const auto filterType = chainSettings.linearPhaseOversampling ? BandOversampler<SampleType>::FilterType::LinearPhaseFIR
+		: BandOversampler<SampleType>::FilterType::MinimumPhaseIIR;
+	const auto detector = chainSettings.rmsEnvelope ? EnvelopeFollower<SampleType>::Detector::Rms
+		: EnvelopeFollower<SampleType>::Detector::Peak;
+
+	for (size_t band = 0; band < bands.size(); ++band)
+	{
+		bands[band].setDrive(chainSettings.bandDriveInDecibels[band]);
+		bands[band].setMix(chainSettings.bandMix[band]);
+		bands[band].setCurve((WaveshaperCurve)chainSettings.bandCurves[band]);
+		bands[band].setOversampling(chainSettings.oversamplingStages, filterType);
+		bands[band].setAntialiasing((AntialiasingMode)chainSettings.antialiasingMode);
+		bands[band].setDynamics(chainSettings.bandDynamicsInDecibels[band]);
+		bands[band].setEnvelope(detector, chainSettings.envelopeAttackMilliseconds, chainSettings.envelopeReleaseMilliseconds);
+	}
+}
+
+template <typename SampleType>
+void MultibandedDistortionPluginAudioProcessor::processBands(int numActiveGroups, int numSamples, const ChainSettings& chainSettings)
+{
+	auto& channelGroups = getChannelGroups<SampleType>();
+
+	// In IIR mode nothing uses the kernels, so nothing is designed either.
+	const LinearPhaseKernels::KernelSet* kernels = nullptr;
+
+	if (chainSettings.linearPhaseCrossover)
+	{
+		linearPhaseKernels.request(chainSettings.numBands, chainSettings.crossoverFreqs, chainSettings.crossoverPartitionOrder);
+		linearPhaseKernels.update(numSamples);
+		kernels = &linearPhaseKernels.getCurrent();
+	}
+
+	{
+		MULTIBAND_TRACE_SCOPE(traceRecorder, DspTrace::Stage::Crossover, -1, numSamples);
+
+		for (int i = 0; i < numActiveGroups; ++i)
+			channelGroups.getUnchecked(i)->split(kernels);
+	}
+
+	const auto numBands = channelGroups.getFirst()->getNumBands();
+	linkEnvelopes<SampleType>(numActiveGroups, numBands, numSamples, chainSettings);
+
+	// One task per band of every group, so wider layouts spread over more workers.
+	auto processBand = [&channelGroups, this, numBands, numSamples](int task)
+	{
+		auto& group = *channelGroups.getUnchecked(task / numBands);
+		const auto band = task % numBands;
+
+		MULTIBAND_TRACE_SCOPE(bandTraceEvents[(size_t)task], DspTrace::Stage::Band, band, numSamples);
+		auto bandBlock = group.getBand(band, (size_t)numSamples);
+		group.bands[(size_t)band].advance(numSamples);
+		group.bands[(size_t)band].process(bandBlock);
+	};
+
+	const auto numTasks = numActiveGroups * numBands;
+
+	// Below this much work per band the hand-off costs more than it saves.
+	const auto workPerBand = (size_t)numSamples << chainSettings.oversamplingStages;
+
+	if (chainSettings.parallelBands && workerPool.getNumWorkers() > 0 && workPerBand >= minimumParallelSamples)
+	{
+		workerPool.run(numTasks, processBand);
+	}
+	else
+	{
+		for (int task = 0; task < numTasks; ++task)
+			processBand(task);
+	}
+
+	if constexpr (DspTrace::isEnabled())
+		for (int task = 0; task < numTasks; ++task)
+			traceRecorder.record(bandTraceEvents[(size_t)task]);
+
+	MULTIBAND_TRACE_SCOPE(traceRecorder, DspTrace::Stage::BandSum, -1, numSamples);
+
+	for (int i = 0; i < numActiveGroups; ++i)
+	{
+		auto& group = *channelGroups.getUnchecked(i);
+		group.block.clear();
+
+		for (int band = 0; band < numBands; ++band)
+			group.block.add(group.getBand(band, (size_t)numSamples));
+	}
+}
+
+template <typename SampleType>
+void MultibandedDistortionPluginAudioProcessor::linkEnvelopes(int numActiveGroups, int numBands, int numSamples, const ChainSettings& chainSettings)
+{
+	using Follower = EnvelopeFollower<SampleType>;
+	auto& channelGroups = getChannelGroups<SampleType>();
+	const auto link = (typename Follower::Link)juce::jlimit(0, 2, chainSettings.envelopeLink);
+	const auto detector = chainSettings.rmsEnvelope ? Follower::Detector::Rms : Follower::Detector::Peak;
+
+	// Every group sees the bands split by now, so one level can be taken across all of their channels.
+	for (int band = 0; band < numBands; ++band)
+	{
+		const float* level = nullptr;
+
+		if (link != Follower::Link::Unlinked && channelGroups.getFirst()->bands[(size_t)band].isDynamic())
+		{
+			auto* linked = linkedLevels.getWritePointer(band);
+			size_t totalLanes = 0;
+
+			for (int i = 0; i < numActiveGroups; ++i)
+			{
+				auto& group = *channelGroups.getUnchecked(i);
+				Follower::accumulateLinked(group.getBand(band, (size_t)numSamples).getChannelPointer(0), group.numActiveLanes,
+					linked, (size_t)numSamples, link, detector, i == 0);
+				totalLanes += group.numActiveLanes;
+			}
+
+			Follower::finishLinked(linked, (size_t)numSamples, link, detector, totalLanes);
+			level = linked;
+		}
+
+		for (int i = 0; i < numActiveGroups; ++i)
+			channelGroups.getUnchecked(i)->bands[(size_t)band].setLinkedLevel(level);
+	}
+}
+
+template <typename SampleType>
+void MultibandedDistortionPluginAudioProcessor::processChain(ChannelGroup<SampleType>& group, const juce::dsp::AudioBlock<juce::dsp::SIMDRegister<SampleType>>& block)
+{
+	auto& chain = group.chain;
+	auto ioBlock = block;
+	juce::dsp::ProcessContextReplacing<juce::dsp::SIMDRegister<SampleType>> context(ioBlock);
+
+	// Stage by stage rather than chain.process(), so each can be traced.
+	{
+		MULTIBAND_TRACE_SCOPE(traceRecorder, DspTrace::Stage::LowCut, -1, (int)block.getNumSamples());
+		group.processCut(chain.template get<ChainPositions::LowCut>(), group.numLowCutStages, context);
+	}
+	{
+		MULTIBAND_TRACE_SCOPE(traceRecorder, DspTrace::Stage::Peak, -1, (int)block.getNumSamples());
+		chain.template get<ChainPositions::Peak>().process(context);
+	}
+	{
+		MULTIBAND_TRACE_SCOPE(traceRecorder, DspTrace::Stage::HighCut, -1, (int)block.getNumSamples());
+		group.processCut(chain.template get<ChainPositions::HighCut>(), group.numHighCutStages, context);
+	}
+}
+
+template <typename SampleType>
+void MultibandedDistortionPluginAudioProcessor::processChainInterpolated(ChannelGroup<SampleType>& group, const juce::dsp::AudioBlock<juce::dsp::SIMDRegister<SampleType>>& segment)
+{
+	auto& chain = group.chain;
+	const auto numSamples = (int)segment.getNumSamples();
+	const auto& to = coefficientEngine.getPeakCoefficients();
+	auto* samples = segment.getChannelPointer(0);
+
+	{
+		MULTIBAND_TRACE_SCOPE(traceRecorder, DspTrace::Stage::LowCut, -1, numSamples);
+		group.processCutRamped(chain.template get<ChainPositions::LowCut>(), group.numLowCutStages,
+			coefficientEngine.getPreviousLowCutCoefficients(), coefficientEngine.getLowCutCoefficients(), samples, numSamples);
+	}
+	{
+		MULTIBAND_TRACE_SCOPE(traceRecorder, DspTrace::Stage::Peak, -1, numSamples);
+
+		auto& peak = chain.template get<ChainPositions::Peak>();
+		auto* rawCoefficients = peak.coefficients->getRawCoefficients();
+
+		CoefficientRamp<SampleType> ramp;
+		ramp.start(coefficientEngine.getPreviousPeakCoefficients(), to, numSamples);
+
+		for (int i = 0; i < numSamples; ++i)
+		{
+			ramp.next(rawCoefficients);
+			samples[i] = peak.processSample(samples[i]);
+		}
+
+		// Land exactly on the target rather than on the accumulated ramp.
+		group.updateCoefficients(*peak.coefficients, to);
+	}
+	{
+		MULTIBAND_TRACE_SCOPE(traceRecorder, DspTrace::Stage::HighCut, -1, numSamples);
+		group.processCutRamped(chain.template get<ChainPositions::HighCut>(), group.numHighCutStages,
+			coefficientEngine.getPreviousHighCutCoefficients(), coefficientEngine.getHighCutCoefficients(), samples, numSamples);
+	}
+}
+
+void MultibandedDistortionPluginAudioProcessor::timerCallback()
+{
+	const auto latency = pendingLatency.load(std::memory_order_relaxed);
+
+	if (latency != getLatencySamples())
+		setLatencySamples(latency);
+
+	eventScheduler.syncParameters();
+
+	// The workers only exist while "Parallel Bands" is on.
+	workerPool.setEnabled(parallelBands->load() >= 0.5f);
+
+	// Once the audio thread has switched programs, the parameters and the host follow.
+	const auto generation = appliedGeneration.load(std::memory_order_acquire);
+
+	if (generation != syncedGeneration.load(std::memory_order_relaxed))
+	{
+		presetBank.applyToParameters(appliedProgram.load(std::memory_order_relaxed));
+		syncedGeneration.store(generation, std::memory_order_release);
+		updateHostDisplay(juce::AudioProcessorListener::ChangeDetails().withProgramChanged(true));
+	}
 }
 
 //==============================================================================
@@ -187,6 +787,9 @@ void MultibandedDistortionPluginAudioProcessor::getStateInformation(juce::Memory
 	// You should use this method to store your parameters in the memory block.
 	// You could do that either as raw data, or use the XML or ValueTree classes
 	// as intermediaries to make it easy to save and load complex data.
+	apvts.state.setProperty("Program", getCurrentProgram(), nullptr);
+	apvts.state.removeChild(apvts.state.getChildWithName(EventScheduler::stateType), nullptr);
+	apvts.state.appendChild(eventScheduler.getState(), nullptr);
 	juce::MemoryOutputStream mos(destData, true);
 	apvts.state.writeToStream(mos);
 }
@@ -199,43 +802,45 @@ void MultibandedDistortionPluginAudioProcessor::setStateInformation(const void*
 	if (tree.isValid())
 	{
 		apvts.replaceState(tree);
-		
+		currentProgram = juce::jlimit(0, presetBank.size() - 1, (int)tree.getProperty("Program", 0));
+		eventScheduler.setState(tree.getChildWithName(EventScheduler::stateType));
 	}
 }
 
-ChainSettings getChainSettings(juce::AudioProcessorValueTreeState& apvts)
+bool MultibandedDistortionPluginAudioProcessor::splitsAtTicks() const noexcept
 {
-	ChainSettings settings;
-
-	settings.peakGainInDecibels = apvts.getRawParameterValue("Peak Gain")->load();
-
-
-	return settings;
+	// The FIR kernels take far longer to build than a tick lasts, so they stay where the parameters put them.
+	return modulationEngine.modulatesCrossovers() && !coefficientEngine.getChainSettings().linearPhaseCrossover;
 }
 
-void MultibandedDistortionPluginAudioProcessor::updatePeakFilter(const ChainSettings& chainSettings)
+void MultibandedDistortionPluginAudioProcessor::updateFilters()
 {
-	auto peakCoefficents = juce::dsp::IIR::Coefficients<float>::makePeakFilter(getSampleRate(), chainSettings.peakFreq, chainSettings.peakQuality, juce::Decibels::decibelsToGain(chainSettings.peakGainInDecibels));
-
-	*leftChain.get<ChainPositions::Peak>().coefficients = *peakCoefficents;
-	*rightChain.get<ChainPositions::Peak>().coefficients = *peakCoefficents;
-
-	updateCoefficients(leftChain.get<ChainPositions::Peak>().coefficients, peakCoefficents);
-	updateCoefficients(rightChain.get<ChainPositions::Peak>().coefficients, peakCoefficents);
+	const auto& lowCut = coefficientEngine.getLowCutCoefficients();
+	const auto& peak = coefficientEngine.getPeakCoefficients();
+	const auto& highCut = coefficientEngine.getHighCutCoefficients();
 
-}
-void MultibandedDistortionPluginAudioProcessor::updateCoefficients(Coefficients& old, const Coefficients& replacements)
-{
-	*old = *replacements;
+	auto update = [&](auto& groups)
+	{
+		for (auto* group : groups)
+		{
+			group->updateCutFilter(group->chain.template get<ChainPositions::LowCut>(), lowCut);
+			group->updateCoefficients(*group->chain.template get<ChainPositions::Peak>().coefficients, peak);
+			group->updateCutFilter(group->chain.template get<ChainPositions::HighCut>(), highCut);
+		}
+	};
+
+	update(floatGroups);
+	update(doubleGroups);
 }
 
 juce::AudioProcessorValueTreeState::ParameterLayout MultibandedDistortionPluginAudioProcessor::createParameterLayout()
 {
 	juce::AudioProcessorValueTreeState::ParameterLayout layout;
 
-	layout.add(std::make_unique<juce::AudioParameterFloat>("Peak Gain", "Peak Gain", juce::NormalisableRange<float>(-24.f, 24.f, 0.1f, 1.f), 0.0f));
-
-
+	forEachParameter([&layout](const ParameterDescriptor& descriptor, int index)
+	{
+		layout.add(makeParameter(descriptor, index));
+	});
 
 	return layout;
 }
@@ -9,18 +9,23 @@
 #pragma once
 
 #include <JuceHeader.h>
+#include "ChainSettings.h"
+#include "CoefficientEngine.h"
+#include "ChannelGroup.h"
+#include "BandWorkerPool.h"
+#include "RealtimeSafety.h"
+#include "DspTrace.h"
+#include "LoadMeter.h"
+#include "SpectrumAnalyzer.h"
+#include "PresetBank.h"
+#include "EventScheduler.h"
+#include "ModulationEngine.h"
 
-
-
-struct ChainSettings
-{
-    float peakFreq{ 1200 }, peakGainInDecibels{ 0 }, peakQuality{ 0.1f };
-};
-ChainSettings getChainSettings(juce::AudioProcessorValueTreeState& apvts);
 //==============================================================================
 /**
 */
 class MultibandedDistortionPluginAudioProcessor  : public juce::AudioProcessor
+                                                 , private juce::Timer
                             #if JucePlugin_Enable_ARA
                              , public juce::AudioProcessorARAExtension
                             #endif
@@ -39,6 +44,8 @@ public:
    #endif
 
     void processBlock (juce::AudioBuffer<float>&, juce::MidiBuffer&) override;
+    void processBlock (juce::AudioBuffer<double>&, juce::MidiBuffer&) override;
+    bool supportsDoublePrecisionProcessing() const override { return true; }
 
     //==============================================================================
     juce::AudioProcessorEditor* createEditor() override;
@@ -63,25 +70,120 @@ public:
     void getStateInformation (juce::MemoryBlock& destData) override;
     void setStateInformation (const void* data, int sizeInBytes) override;
 
+    LoadMeter& getLoadMeter() noexcept { return loadMeter; }
+    EventScheduler& getEventScheduler() noexcept { return eventScheduler; }
+    SpectrumAnalyzer& getSpectrumAnalyzer() noexcept { return spectrumAnalyzer; }
+
+    /** Message thread: replaces the program bank with a library file's; returns an error message, or an empty string. */
+    juce::String loadProgramLibrary(const juce::File& file);
+
+    /** Where the DSP trace goes when it is compiled in; .json for Chrome trace format. */
+    void setTraceFile(const juce::File& file) { traceFile = file; }
+
     static juce::AudioProcessorValueTreeState::ParameterLayout createParameterLayout();
     juce::AudioProcessorValueTreeState apvts{ *this, nullptr, "Parameters", createParameterLayout() };
 private:
-    using Filter = juce::dsp::IIR::Filter<float>;
-    using Cutfilter = juce::dsp::ProcessorChain<Filter, Filter, Filter, Filter>;
-    using Monochain = juce::dsp::ProcessorChain<Cutfilter, Filter, Cutfilter>;
-    Monochain leftChain, rightChain;
-     
-    enum ChainPositions
+    // The bus is split into groups of SIMD-width channels, one channel per lane,
+    // sized to the layout in prepareToPlay. Only the set for the precision in
+    // use holds any; both run through the same templated code below.
+    juce::OwnedArray<ChannelGroup<float>> floatGroups;
+    juce::OwnedArray<ChannelGroup<double>> doubleGroups;
+
+    template <typename SampleType>
+    juce::OwnedArray<ChannelGroup<SampleType>>& getChannelGroups() noexcept
     {
-        LowCut,
-        Peak,
-        HighCut,
-
-    };
+        if constexpr (std::is_same_v<SampleType, double>)
+            return doubleGroups;
+        else
+            return floatGroups;
+    }
+
+    // Opt-in via "Parallel Bands", which the timer follows by starting or stopping
+    // the workers; small blocks always stay on the audio thread.
+    BandWorkerPool workerPool;
+    std::atomic<float>* parallelBands = apvts.getRawParameterValue(getParameterID(Param::ParallelBands));
+    static constexpr size_t minimumParallelSamples = 1024;
+
+    // Shared by every group; only designed and consulted in "Linear Phase FIR"
+    // crossover mode. Switching to it crossfades in the new kernels once built.
+    LinearPhaseKernels linearPhaseKernels;
+
+    // The audio thread only publishes the latency; a message-thread timer reports
+    // changes, so nothing on the audio path posts messages or takes locks.
+    std::atomic<int> pendingLatency{ 0 };
+    void timerCallback() override;
+
+    LoadMeter loadMeter;
+
+    // Neutral-settings fast path: the chain fades out and is skipped while it would
+    // be unity gain. Silence: after the tail has rung out the processor sleeps until
+    // the input comes back. The tail is also what getTailLengthSeconds() reports.
+    static constexpr double chainFadeSeconds = 0.01;
+    float chainLevel = 1.f;
+    int chainFadeSamples = 441;
+    juce::int64 silentSamples = 0;
+    bool asleep = false;
+    std::atomic<int> tailSamples{ 0 };
+    void updateTail() noexcept;
+
+    // Only pushed to while the editor has the analyser running.
+    SpectrumAnalyzer spectrumAnalyzer;
+
+    // Only used when MULTIBAND_DSP_TRACE is on. Band tasks may run on worker
+    // threads, so they time into their own slots and are recorded after joining.
+    DspTrace::Recorder traceRecorder;
+    std::unique_ptr<DspTrace::Writer> traceWriter;
+    juce::File traceFile;
+    std::vector<DspTrace::Event> bandTraceEvents;
+     
 
-    void updatePeakFilter(const ChainSettings& chainSettings);
-    using Coefficients = Filter::CoefficientsPtr;
-    static void updateCoefficients(Coefficients& old, const Coefficients& replacements); 
+    CoefficientEngine coefficientEngine{ apvts };
+
+    // MIDI controllers take effect on their own sample; the timer brings the
+    // parameters along afterwards.
+    EventScheduler eventScheduler{ apvts };
+
+    // LFOs and macros, evaluated once per control interval. While an IIR crossover
+    // is a target, segments are cut at its ticks so each one has a single split.
+    ModulationEngine modulationEngine;
+
+    // setCurrentProgram() only posts the index. The audio thread fades the output
+    // out, applies the preset's prepared snapshot at silence and fades back in;
+    // the timer then moves the parameters to match, and only after that does the
+    // engine listen to them again.
+    PresetBank presetBank{ *this };
+    static constexpr double programFadeSeconds = 0.005;
+    std::atomic<int> pendingProgram{ -1 }, currentProgram{ 0 }, appliedProgram{ 0 };
+    std::atomic<juce::uint32> appliedGeneration{ 0 }, syncedGeneration{ 0 };
+    std::atomic<bool> prepared{ false };
+    int programTarget = -1;
+    int programFadeSamples = 220;
+    float programLevel = 1.f;
+    template <typename SampleType> void applyProgram(int index);
+
+    // Every buffer below is sized for this many samples; process() cuts longer host blocks down to it.
+    int maximumSegmentSamples = 0;
+
+    template <typename SampleType> void process(juce::AudioBuffer<SampleType>& buffer, juce::MidiBuffer& midiMessages);
+    template <typename SampleType> void processSegment(juce::AudioBuffer<SampleType>& buffer);
+    template <typename SampleType> int prepareChannelGroups(double sampleRate, int samplesPerBlock);
+    /** The crossover's delay plus the oversampling's, for the current settings. */
+    double getLatencyOfBands() const noexcept;
+
+    template <typename SampleType> void updateBandSettings(ChannelGroup<SampleType>& group, const ChainSettings& chainSettings);
+    template <typename SampleType> void processBands(int numActiveGroups, int numSamples, const ChainSettings& chainSettings);
+
+    // One detector level per band, shared by every channel when "Envelope Link" is on.
+    juce::AudioBuffer<float> linkedLevels;
+    template <typename SampleType> void linkEnvelopes(int numActiveGroups, int numBands, int numSamples, const ChainSettings& chainSettings);
+    template <typename SampleType> void processChain(ChannelGroup<SampleType>& group, const juce::dsp::AudioBlock<juce::dsp::SIMDRegister<SampleType>>& block);
+    template <typename SampleType> void processChainInterpolated(ChannelGroup<SampleType>& group, const juce::dsp::AudioBlock<juce::dsp::SIMDRegister<SampleType>>& segment);
+
+    /** Installs the engine's current coefficients in every group's chain. */
+    void updateFilters();
+
+    /** True while a modulated IIR crossover needs every segment to start on a control tick. */
+    bool splitsAtTicks() const noexcept;
 
     //==============================================================================
     JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (MultibandedDistortionPluginAudioProcessor)
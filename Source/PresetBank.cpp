@@ -0,0 +1,183 @@
+/*
+  ==============================================================================
+
+	Program bank read from a compact binary preset library.
+
+  ==============================================================================
+*/
+
+#include "PresetBank.h"
+
+namespace
+{
+	constexpr char libraryMagic[4] = { 'M', 'B', 'D', 'P' };
+
+	juce::String readString(juce::InputStream& stream)
+	{
+		const auto length = (int)(juce::uint8)stream.readByte();
+		juce::HeapBlock<char> utf8((size_t)length + 1, true);
+		stream.read(utf8.get(), length);
+		return juce::String::fromUTF8(utf8.get(), length);
+	}
+
+	bool writeString(juce::OutputStream& stream, const juce::String& text)
+	{
+		// Whole characters only, within the one-byte length.
+		auto truncated = text;
+
+		while (truncated.getNumBytesAsUTF8() > 255)
+			truncated = truncated.dropLastCharacters(1);
+
+		const auto length = (int)truncated.getNumBytesAsUTF8();
+		return stream.writeByte((char)length) && stream.write(truncated.toRawUTF8(), (size_t)length);
+	}
+}
+
+PresetBank::PresetBank(juce::AudioProcessor& processor)
+{
+	for (auto* parameter : processor.getParameters())
+	{
+		if (auto* ranged = dynamic_cast<juce::RangedAudioParameter*>(parameter))
+		{
+			parameters.add(ranged);
+			parameterIDs.add(ranged->getParameterID());
+		}
+	}
+
+	// Presets store values in slot order, which prepare() relies on.
+	jassert(parameters.size() == numParameterSlots);
+
+	for (auto* parameter : parameters)
+		defaultValues.push_back(parameter->convertFrom0to1(parameter->getDefaultValue()));
+
+	addPreset("Default", defaultValues);
+}
+
+juce::File PresetBank::getDefaultLibraryFile()
+{
+	return juce::File::getSpecialLocation(juce::File::userApplicationDataDirectory)
+		.getChildFile("MultibandedDistortionPlugin")
+		.getChildFile("Presets.mbdp");
+}
+
+juce::String PresetBank::loadFrom(const juce::File& file)
+{
+	juce::MemoryMappedFile map(file, juce::MemoryMappedFile::readOnly);
+
+	if (map.getData() == nullptr)
+		return "Cannot open " + file.getFullPathName();
+
+	juce::MemoryInputStream stream(map.getData(), map.getSize(), false);
+	char magic[4]{};
+
+	if (stream.read(magic, 4) != 4 || std::memcmp(magic, libraryMagic, 4) != 0)
+		return file.getFileName() + " is not a preset library";
+
+	const auto version = (juce::uint16)stream.readShort();
+
+	if (version == 0 || version > formatVersion)
+		return file.getFileName() + " has unsupported format version " + juce::String(version);
+
+	const auto numStored = (int)(juce::uint16)stream.readShort();
+	const auto numPresets = (juce::int64)(juce::uint32)stream.readInt();
+
+	// Which of our parameters each stored value belongs to; -1 for ones this build doesn't have.
+	std::vector<int> destinations;
+
+	for (int i = 0; i < numStored; ++i)
+		destinations.push_back(parameterIDs.indexOf(readString(stream)));
+
+	if (numPresets == 0)
+		return file.getFileName() + " contains no presets";
+
+	// Every preset needs at least its name length and its values.
+	if (stream.getNumBytesRemaining() < numPresets * (1 + (juce::int64)numStored * 4))
+		return file.getFileName() + " is truncated";
+
+	std::vector<Preset> decoded((size_t)numPresets);
+
+	for (auto& preset : decoded)
+	{
+		preset.name = readString(stream);
+		preset.values = defaultValues;
+
+		if (stream.getNumBytesRemaining() < (juce::int64)numStored * 4)
+			return file.getFileName() + " is truncated";
+
+		for (const auto destination : destinations)
+		{
+			const auto value = stream.readFloat();
+
+			if (destination >= 0 && std::isfinite(value))
+			{
+				const auto& range = parameters[destination]->getNormalisableRange();
+				preset.values[(size_t)destination] = range.snapToLegalValue(juce::jlimit(range.start, range.end, value));
+			}
+		}
+	}
+
+	presets = std::move(decoded);
+	return {};
+}
+
+bool PresetBank::writeTo(juce::OutputStream& stream) const
+{
+	auto ok = stream.write(libraryMagic, 4)
+		&& stream.writeShort((short)formatVersion)
+		&& stream.writeShort((short)parameterIDs.size())
+		&& stream.writeInt((int)presets.size());
+
+	for (const auto& id : parameterIDs)
+		ok = ok && writeString(stream, id);
+
+	for (const auto& preset : presets)
+	{
+		ok = ok && writeString(stream, preset.name);
+
+		for (const auto value : preset.values)
+			ok = ok && stream.writeFloat(value);
+	}
+
+	return ok;
+}
+
+void PresetBank::addPreset(const juce::String& name, std::vector<float> values)
+{
+	jassert(values.size() == (size_t)parameters.size());
+
+	Preset preset;
+	preset.name = name;
+	preset.values = std::move(values);
+	presets.push_back(std::move(preset));
+}
+
+std::vector<float> PresetBank::getCurrentValues() const
+{
+	std::vector<float> values;
+
+	for (auto* parameter : parameters)
+		values.push_back(parameter->convertFrom0to1(parameter->getValue()));
+
+	return values;
+}
+
+void PresetBank::prepare(double sampleRate)
+{
+	for (auto& preset : presets)
+	{
+		const auto settings = makeChainSettings([&preset](Param param, int index)
+		{
+			return preset.values[(size_t)getParameterSlot(param, index)];
+		});
+
+		preset.snapshot = CoefficientEngine::makeSnapshot(settings, sampleRate);
+	}
+}
+
+void PresetBank::applyToParameters(int index) const
+{
+	const auto& values = presets[(size_t)index].values;
+
+	for (int i = 0; i < parameters.size(); ++i)
+		parameters[i]->setValueNotifyingHost(parameters[i]->convertTo0to1(values[(size_t)i]));
+}
@@ -0,0 +1,80 @@
+/*
+  ==============================================================================
+
+	Program bank read from a compact binary preset library.
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+#include "ChainSettings.h"
+#include "CoefficientEngine.h"
+
+//==============================================================================
+/**
+	The presets behind getNumPrograms() and setCurrentProgram().
+
+	A library file is read through a memory map and decoded up front. Each preset
+	holds one plain value per processor parameter, and prepare() turns those into
+	a CoefficientEngine::Snapshot for the sample rate, so switching programs
+	copies prepared data and never parses, allocates or builds coefficients.
+
+	Library format, little-endian, version 1:
+		char[4]   "MBDP"
+		uint16    format version
+		uint16    number of parameters, P
+		uint32    number of presets
+		P times:  uint8 length, UTF-8 parameter ID
+		per preset: uint8 length, UTF-8 name, then P float32 plain values
+
+	Values are matched to parameters by ID, so a library keeps loading after
+	parameters are added or removed; parameters it doesn't mention get their
+	defaults.
+*/
+class PresetBank
+{
+public:
+	struct Preset
+	{
+		juce::String name;
+		std::vector<float> values;
+		CoefficientEngine::Snapshot snapshot;
+	};
+
+	static constexpr juce::uint16 formatVersion = 1;
+
+	/** Captures the processor's parameter list; starts with a single preset of default values. */
+	explicit PresetBank(juce::AudioProcessor& processor);
+
+	/** Where the bank is loaded from when the plug-in is created. */
+	static juce::File getDefaultLibraryFile();
+
+	/** Replaces the presets with a library's; returns an error message, or an empty string. */
+	juce::String loadFrom(const juce::File& file);
+	bool writeTo(juce::OutputStream& stream) const;
+
+	void addPreset(const juce::String& name, std::vector<float> values);
+
+	/** The parameters' current plain values, in the order presets store them. */
+	std::vector<float> getCurrentValues() const;
+
+	/** Builds every preset's snapshot for the sample rate; call from prepareToPlay. */
+	void prepare(double sampleRate);
+
+	/** Message thread: moves the parameters to a preset's values, telling the host. */
+	void applyToParameters(int index) const;
+
+	int size() const noexcept { return (int)presets.size(); }
+	const Preset& operator[](int index) const noexcept { return presets[(size_t)index]; }
+	void setName(int index, const juce::String& name) { presets[(size_t)index].name = name; }
+
+	void swapWith(PresetBank& other) noexcept { std::swap(presets, other.presets); }
+
+private:
+	juce::Array<juce::RangedAudioParameter*> parameters;
+	juce::StringArray parameterIDs;
+	std::vector<float> defaultValues;
+	std::vector<Preset> presets;
+};
@@ -0,0 +1,335 @@
+/*
+  ==============================================================================
+
+	Debug instrumentation that catches real-time-unsafe calls on audio threads.
+
+  ==============================================================================
+*/
+
+#include "RealtimeSafety.h"
+
+#if MULTIBAND_RT_SAFETY_CHECKS
+
+#if JUCE_LINUX || JUCE_MAC
+ #include <execinfo.h>
+#endif
+
+#if JUCE_LINUX
+ #include <dlfcn.h>
+ #include <poll.h>
+ #include <pthread.h>
+ #include <semaphore.h>
+ #include <sys/select.h>
+ #include <unistd.h>
+#endif
+
+namespace RealtimeSafety
+{
+	namespace
+	{
+		constexpr int maxRecorded = 256;
+		constexpr int maxFrames = 32;
+
+		// Filled from the audio thread, so everything is allocated up front.
+		struct Violation
+		{
+			ViolationKind kind;
+			const char* function;
+			int numFrames;
+			void* frames[maxFrames];
+		};
+
+		Violation violations[maxRecorded];
+		std::atomic<int> numViolations{ 0 };
+
+		thread_local int audioDepth = 0;
+		thread_local bool reporting = false;
+
+		int captureStack(void** frames) noexcept
+		{
+		   #if JUCE_LINUX || JUCE_MAC
+			return backtrace(frames, maxFrames);
+		   #else
+			juce::ignoreUnused(frames);
+			return 0;
+		   #endif
+		}
+
+		// backtrace() loads its unwinder on first use, which allocates; get that
+		// out of the way before any audio thread needs it.
+		const bool stackCaptureReady = []
+		{
+			void* frames[maxFrames];
+			return captureStack(frames) >= 0;
+		}();
+
+		const char* getKindName(ViolationKind kind) noexcept
+		{
+			switch (kind)
+			{
+			case ViolationKind::Allocation: return "allocation";
+			case ViolationKind::Deallocation: return "deallocation";
+			case ViolationKind::MutexLock: return "mutex lock";
+			case ViolationKind::BlockingCall: return "blocking call";
+			}
+
+			return "";
+		}
+	}
+
+	ScopedAudioThread::ScopedAudioThread() noexcept { ++audioDepth; }
+	ScopedAudioThread::~ScopedAudioThread() noexcept { --audioDepth; }
+
+	void reportViolation(ViolationKind kind, const char* function) noexcept
+	{
+		if (audioDepth == 0 || reporting)
+			return;
+
+		// Capturing the stack may itself call back into the interceptors.
+		reporting = true;
+
+		const auto index = numViolations.fetch_add(1, std::memory_order_relaxed);
+
+		if (index < maxRecorded)
+		{
+			auto& violation = violations[index];
+			violation.kind = kind;
+			violation.function = function;
+			violation.numFrames = captureStack(violation.frames);
+		}
+
+		reporting = false;
+	}
+
+	int getNumViolations() noexcept
+	{
+		return numViolations.load(std::memory_order_relaxed);
+	}
+
+	void clearViolations() noexcept
+	{
+		numViolations.store(0, std::memory_order_relaxed);
+	}
+
+	juce::String createReport()
+	{
+		const auto total = getNumViolations();
+
+		if (total == 0)
+			return "No real-time safety violations.\n";
+
+		juce::String report;
+		report << total << " real-time safety violation(s) on audio threads";
+
+		if (total > maxRecorded)
+			report << " (first " << maxRecorded << " recorded)";
+
+		report << "\n";
+
+		// The same call site usually fires every block; print each stack once.
+		const auto numRecorded = juce::jmin(total, maxRecorded);
+		std::vector<int> counts((size_t)numRecorded);
+
+		for (int i = 0; i < numRecorded; ++i)
+		{
+			int first = i;
+
+			for (int j = 0; j < i; ++j)
+			{
+				const auto& a = violations[i];
+				const auto& b = violations[j];
+
+				if (a.kind == b.kind && a.numFrames == b.numFrames && std::equal(a.frames, a.frames + a.numFrames, b.frames))
+				{
+					first = j;
+					break;
+				}
+			}
+
+			++counts[(size_t)first];
+		}
+
+		for (int i = 0; i < numRecorded; ++i)
+		{
+			if (counts[(size_t)i] == 0)
+				continue;
+
+			const auto& violation = violations[i];
+			report << "\n" << getKindName(violation.kind) << " in " << violation.function << " (x" << counts[(size_t)i] << ")\n";
+
+		   #if JUCE_LINUX || JUCE_MAC
+			if (auto* symbols = backtrace_symbols(violation.frames, violation.numFrames))
+			{
+				// Skip the interceptor and reportViolation frames.
+				for (int frame = 2; frame < violation.numFrames; ++frame)
+					report << "    " << symbols[frame] << "\n";
+
+				free(symbols);
+			}
+		   #endif
+		}
+
+		return report;
+	}
+}
+
+//==============================================================================
+#if JUCE_LINUX
+// glibc lets an executable replace the allocator outright; its own entry
+// points stay reachable under these names.
+extern "C"
+{
+	void* __libc_malloc(size_t);
+	void* __libc_calloc(size_t, size_t);
+	void* __libc_realloc(void*, size_t);
+	void* __libc_memalign(size_t, size_t);
+	void __libc_free(void*);
+}
+
+namespace
+{
+	/** Looks the real function up on first use, without statics that could lock. */
+	template <typename Function>
+	Function getNext(std::atomic<Function>& cache, const char* name) noexcept
+	{
+		auto function = cache.load(std::memory_order_relaxed);
+
+		if (function == nullptr)
+		{
+			function = reinterpret_cast<Function>(dlsym(RTLD_NEXT, name));
+			cache.store(function, std::memory_order_relaxed);
+		}
+
+		return function;
+	}
+
+	using RealtimeSafety::ViolationKind;
+	using RealtimeSafety::reportViolation;
+}
+
+#define MULTIBAND_INTERCEPT(returnType, name, kind, parameters, arguments) \
+	extern "C" returnType name parameters \
+	{ \
+		using Next = returnType (*) parameters; \
+		static std::atomic<Next> next{ nullptr }; \
+		reportViolation(kind, #name); \
+		return getNext(next, #name) arguments; \
+	}
+
+extern "C"
+{
+	void* malloc(size_t size)
+	{
+		reportViolation(ViolationKind::Allocation, "malloc");
+		return __libc_malloc(size);
+	}
+
+	void* calloc(size_t count, size_t size)
+	{
+		reportViolation(ViolationKind::Allocation, "calloc");
+		return __libc_calloc(count, size);
+	}
+
+	void* realloc(void* pointer, size_t size)
+	{
+		reportViolation(ViolationKind::Allocation, "realloc");
+		return __libc_realloc(pointer, size);
+	}
+
+	void* memalign(size_t alignment, size_t size)
+	{
+		reportViolation(ViolationKind::Allocation, "memalign");
+		return __libc_memalign(alignment, size);
+	}
+
+	void* aligned_alloc(size_t alignment, size_t size)
+	{
+		reportViolation(ViolationKind::Allocation, "aligned_alloc");
+		return __libc_memalign(alignment, size);
+	}
+
+	int posix_memalign(void** result, size_t alignment, size_t size)
+	{
+		reportViolation(ViolationKind::Allocation, "posix_memalign");
+		*result = __libc_memalign(alignment, size);
+		return *result != nullptr ? 0 : ENOMEM;
+	}
+
+	void free(void* pointer)
+	{
+		if (pointer != nullptr)
+			reportViolation(ViolationKind::Deallocation, "free");
+
+		__libc_free(pointer);
+	}
+}
+
+MULTIBAND_INTERCEPT(int, pthread_mutex_lock, ViolationKind::MutexLock, (pthread_mutex_t* mutex), (mutex))
+MULTIBAND_INTERCEPT(int, pthread_rwlock_rdlock, ViolationKind::MutexLock, (pthread_rwlock_t* lock), (lock))
+MULTIBAND_INTERCEPT(int, pthread_rwlock_wrlock, ViolationKind::MutexLock, (pthread_rwlock_t* lock), (lock))
+MULTIBAND_INTERCEPT(int, pthread_cond_wait, ViolationKind::BlockingCall, (pthread_cond_t* condition, pthread_mutex_t* mutex), (condition, mutex))
+MULTIBAND_INTERCEPT(int, pthread_cond_timedwait, ViolationKind::BlockingCall, (pthread_cond_t* condition, pthread_mutex_t* mutex, const timespec* time), (condition, mutex, time))
+MULTIBAND_INTERCEPT(int, pthread_join, ViolationKind::BlockingCall, (pthread_t thread, void** result), (thread, result))
+MULTIBAND_INTERCEPT(int, sem_wait, ViolationKind::BlockingCall, (sem_t* semaphore), (semaphore))
+MULTIBAND_INTERCEPT(int, nanosleep, ViolationKind::BlockingCall, (const timespec* duration, timespec* remaining), (duration, remaining))
+MULTIBAND_INTERCEPT(int, usleep, ViolationKind::BlockingCall, (useconds_t duration), (duration))
+MULTIBAND_INTERCEPT(ssize_t, read, ViolationKind::BlockingCall, (int descriptor, void* buffer, size_t size), (descriptor, buffer, size))
+MULTIBAND_INTERCEPT(ssize_t, write, ViolationKind::BlockingCall, (int descriptor, const void* buffer, size_t size), (descriptor, buffer, size))
+MULTIBAND_INTERCEPT(int, poll, ViolationKind::BlockingCall, (pollfd* descriptors, nfds_t count, int timeout), (descriptors, count, timeout))
+MULTIBAND_INTERCEPT(int, select, ViolationKind::BlockingCall, (int count, fd_set* readSet, fd_set* writeSet, fd_set* errorSet, timeval* timeout), (count, readSet, writeSet, errorSet, timeout))
+
+#undef MULTIBAND_INTERCEPT
+
+#else
+//==============================================================================
+// Without an allocator to replace, catch what goes through operator new.
+void* operator new(std::size_t size)
+{
+	RealtimeSafety::reportViolation(RealtimeSafety::ViolationKind::Allocation, "operator new");
+
+	if (auto* pointer = std::malloc(size == 0 ? 1 : size))
+		return pointer;
+
+	throw std::bad_alloc();
+}
+
+void* operator new[](std::size_t size)
+{
+	return operator new(size);
+}
+
+void operator delete(void* pointer) noexcept
+{
+	if (pointer != nullptr)
+		RealtimeSafety::reportViolation(RealtimeSafety::ViolationKind::Deallocation, "operator delete");
+
+	std::free(pointer);
+}
+
+void operator delete[](void* pointer) noexcept
+{
+	operator delete(pointer);
+}
+
+void operator delete(void* pointer, std::size_t) noexcept
+{
+	operator delete(pointer);
+}
+
+void operator delete[](void* pointer, std::size_t) noexcept
+{
+	operator delete(pointer);
+}
+#endif
+
+#else
+
+namespace RealtimeSafety
+{
+	void reportViolation(ViolationKind, const char*) noexcept {}
+	int getNumViolations() noexcept { return 0; }
+	void clearViolations() noexcept {}
+	juce::String createReport() { return "Real-time safety checks are not compiled in.\n"; }
+}
+
+#endif
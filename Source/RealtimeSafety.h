@@ -0,0 +1,59 @@
+/*
+  ==============================================================================
+
+	Debug instrumentation that catches real-time-unsafe calls on audio threads.
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+
+// Turned on for the command-line tools by the MULTIBAND_RT_SAFETY_CHECKS CMake
+// option. Never enable it in the plugin itself: it replaces malloc and friends
+// for the whole process.
+#ifndef MULTIBAND_RT_SAFETY_CHECKS
+ #define MULTIBAND_RT_SAFETY_CHECKS 0
+#endif
+
+namespace RealtimeSafety
+{
+	enum class ViolationKind
+	{
+		Allocation,
+		Deallocation,
+		MutexLock,
+		BlockingCall
+	};
+
+	constexpr bool isEnabled() noexcept { return MULTIBAND_RT_SAFETY_CHECKS != 0; }
+
+	/**
+		Marks the current thread as running audio code for the lifetime of the
+		object. With checks enabled, every allocation, lock or blocking call the
+		thread makes meanwhile is recorded as a violation; otherwise this does
+		nothing.
+	*/
+	struct ScopedAudioThread
+	{
+	#if MULTIBAND_RT_SAFETY_CHECKS
+		ScopedAudioThread() noexcept;
+		~ScopedAudioThread() noexcept;
+	#else
+		ScopedAudioThread() noexcept {}
+	#endif
+
+		JUCE_DECLARE_NON_COPYABLE(ScopedAudioThread)
+	};
+
+	/** Called by the interceptors; records a violation if on an audio thread. */
+	void reportViolation(ViolationKind kind, const char* function) noexcept;
+
+	/** Every violation seen, including any past the recorded ones. */
+	int getNumViolations() noexcept;
+	void clearViolations() noexcept;
+
+	/** Recorded violations with symbolised stack traces; call off the audio thread. */
+	juce::String createReport();
+}
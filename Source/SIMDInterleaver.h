@@ -0,0 +1,79 @@
+/*
+  ==============================================================================
+
+	Packs the channels of a block into SIMD lanes so one filter pass covers all
+	of them.
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+
+//==============================================================================
+/**
+	Interleaves up to SIMDRegister<SampleType>::size() channels into a single
+	block of SIMD registers, one channel per lane, and back again.
+
+	Storage is allocated in prepare(); interleave() and deinterleave() only copy.
+	Lanes without a channel are fed silence so their filter state stays at zero.
+*/
+template <typename SampleType>
+class SIMDInterleaver
+{
+public:
+	using Register = juce::dsp::SIMDRegister<SampleType>;
+
+	static constexpr size_t numLanes = Register::size();
+
+	void prepare(int maximumBlockSize)
+	{
+		block = juce::dsp::AudioBlock<Register>(blockData, 1, (size_t)maximumBlockSize);
+		block.clear();
+	}
+
+	juce::dsp::AudioBlock<Register> interleave(const juce::dsp::AudioBlock<SampleType>& source) noexcept
+	{
+		const auto numSamples = source.getNumSamples();
+		const auto numChannels = juce::jmin(source.getNumChannels(), numLanes);
+		jassert(numSamples <= block.getNumSamples());
+		jassert(source.getNumChannels() <= numLanes);
+
+		auto* lanes = reinterpret_cast<SampleType*>(block.getChannelPointer(0));
+
+		for (size_t channel = 0; channel < numChannels; ++channel)
+		{
+			auto* samples = source.getChannelPointer(channel);
+
+			for (size_t i = 0; i < numSamples; ++i)
+				lanes[i * numLanes + channel] = samples[i];
+		}
+
+		for (size_t channel = numChannels; channel < numLanes; ++channel)
+			for (size_t i = 0; i < numSamples; ++i)
+				lanes[i * numLanes + channel] = SampleType();
+
+		return block.getSubBlock(0, numSamples);
+	}
+
+	void deinterleave(const juce::dsp::AudioBlock<SampleType>& destination) const noexcept
+	{
+		const auto numSamples = destination.getNumSamples();
+		const auto numChannels = juce::jmin(destination.getNumChannels(), numLanes);
+
+		auto* lanes = reinterpret_cast<const SampleType*>(block.getChannelPointer(0));
+
+		for (size_t channel = 0; channel < numChannels; ++channel)
+		{
+			auto* samples = destination.getChannelPointer(channel);
+
+			for (size_t i = 0; i < numSamples; ++i)
+				samples[i] = lanes[i * numLanes + channel];
+		}
+	}
+
+private:
+	juce::HeapBlock<char> blockData;
+	juce::dsp::AudioBlock<Register> block;
+};
@@ -0,0 +1,262 @@
+/*
+  ==============================================================================
+
+	Pre/post spectrum analyser fed from the audio thread through lock-free FIFOs.
+
+  ==============================================================================
+*/
+
+#include "SpectrumAnalyzer.h"
+
+class SpectrumAnalyzer::AnalysisThread : public juce::Thread
+{
+public:
+	explicit AnalysisThread(SpectrumAnalyzer& owner)
+		: juce::Thread("Spectrum analyser"), analyzer(owner)
+	{
+	}
+
+	void run() override
+	{
+		int order = 0;
+		std::unique_ptr<juce::dsp::FFT> fft;
+		std::unique_ptr<juce::dsp::WindowingFunction<float>> window;
+		std::vector<float> scratch;
+
+		// A push() that began before the last stop() may still be writing, so only the read
+		// side is ours to move: skip whatever was queued rather than resetting the FIFO.
+		for (auto& channel : analyzer.channels)
+			channel.fifo.finishedRead(channel.fifo.getNumReady());
+
+		while (!threadShouldExit())
+		{
+			const auto requestedOrder = analyzer.fftOrder.load();
+
+			if (requestedOrder != order)
+			{
+				order = requestedOrder;
+				const auto size = 1 << order;
+				fft = std::make_unique<juce::dsp::FFT>(order);
+				window = std::make_unique<juce::dsp::WindowingFunction<float>>((size_t)size, juce::dsp::WindowingFunction<float>::hann, false);
+				scratch.assign((size_t)size * 2, 0.f);
+
+				for (auto& channel : analyzer.channels)
+				{
+					channel.history.assign((size_t)size, 0.f);
+					channel.historyWrite = 0;
+					channel.smoothed.assign((size_t)numPoints, minimumDecibels);
+				}
+			}
+
+			for (auto& channel : analyzer.channels)
+				analyzer.analyse(channel, *fft, *window, scratch, order);
+
+			++analyzer.frameCount;
+			wait(juce::jmax(1, juce::roundToInt(1000.0 / analyzer.frameRate.load())));
+		}
+	}
+
+private:
+	SpectrumAnalyzer& analyzer;
+};
+
+//==============================================================================
+SpectrumAnalyzer::SpectrumAnalyzer() = default;
+
+SpectrumAnalyzer::~SpectrumAnalyzer()
+{
+	stop();
+}
+
+void SpectrumAnalyzer::prepare(double newSampleRate)
+{
+	sampleRate = newSampleRate;
+
+	for (auto& channel : channels)
+	{
+		if (channel.fifoData == nullptr)
+			channel.fifoData.allocate((size_t)channel.fifo.getTotalSize(), true);
+	}
+}
+
+void SpectrumAnalyzer::start()
+{
+	if (thread != nullptr)
+		return;
+
+	for (auto& channel : channels)
+	{
+		if (channel.fifoData == nullptr)
+			channel.fifoData.allocate((size_t)channel.fifo.getTotalSize(), true);
+	}
+
+	thread = std::make_unique<AnalysisThread>(*this);
+	running = true;
+	thread->startThread(juce::Thread::Priority::low);
+}
+
+void SpectrumAnalyzer::stop()
+{
+	running = false;
+
+	if (thread != nullptr)
+	{
+		thread->stopThread(1000);
+		thread.reset();
+	}
+}
+
+void SpectrumAnalyzer::setFFTOrder(int order) noexcept
+{
+	fftOrder = juce::jlimit(minimumFFTOrder, maximumFFTOrder, order);
+}
+
+void SpectrumAnalyzer::setFrameRate(double framesPerSecond) noexcept
+{
+	frameRate = juce::jlimit(1.0, 120.0, framesPerSecond);
+}
+
+template <typename SampleType>
+void SpectrumAnalyzer::push(Tap tap, const juce::AudioBuffer<SampleType>& buffer) noexcept
+{
+	// Acquire pairs with start(), so the FIFO storage is visible once the flag is.
+	if (!running.load(std::memory_order_acquire))
+		return;
+
+	auto& channel = channels[(size_t)tap];
+	const auto numChannels = buffer.getNumChannels();
+	const auto numSamples = juce::jmin(buffer.getNumSamples(), channel.fifo.getFreeSpace());
+
+	if (numChannels == 0 || numSamples == 0)
+		return;
+
+	const auto scale = 1.f / (float)numChannels;
+	const auto scope = channel.fifo.write(numSamples);
+
+	auto mixDown = [&](int destination, int source, int count)
+	{
+		auto* out = channel.fifoData.get() + destination;
+
+		if constexpr (std::is_same_v<SampleType, float>)
+		{
+			juce::FloatVectorOperations::copyWithMultiply(out, buffer.getReadPointer(0, source), scale, count);
+
+			for (int ch = 1; ch < numChannels; ++ch)
+				juce::FloatVectorOperations::addWithMultiply(out, buffer.getReadPointer(ch, source), scale, count);
+		}
+		else
+		{
+			// The display has no use for more than float precision.
+			juce::FloatVectorOperations::clear(out, count);
+
+			for (int ch = 0; ch < numChannels; ++ch)
+			{
+				const auto* in = buffer.getReadPointer(ch, source);
+
+				for (int i = 0; i < count; ++i)
+					out[i] += (float)in[i] * scale;
+			}
+		}
+	};
+
+	mixDown(scope.startIndex1, 0, scope.blockSize1);
+
+	if (scope.blockSize2 > 0)
+		mixDown(scope.startIndex2, scope.blockSize1, scope.blockSize2);
+}
+
+template void SpectrumAnalyzer::push(Tap, const juce::AudioBuffer<float>&) noexcept;
+template void SpectrumAnalyzer::push(Tap, const juce::AudioBuffer<double>&) noexcept;
+
+juce::Path SpectrumAnalyzer::getPath(Tap tap) const
+{
+	const juce::ScopedLock lock(pathLock);
+	return channels[(size_t)tap].path;
+}
+
+float SpectrumAnalyzer::frequencyToProportion(float frequency) const noexcept
+{
+	const auto nyquist = (float)getSampleRate() * 0.5f;
+	return std::log(frequency / 20.f) / std::log(nyquist / 20.f);
+}
+
+void SpectrumAnalyzer::analyse(Channel& channel, juce::dsp::FFT& fft, juce::dsp::WindowingFunction<float>& window,
+	std::vector<float>& scratch, int order)
+{
+	const auto size = 1 << order;
+
+	// Keep the most recent fftSize samples in a circular history.
+	{
+		const auto scope = channel.fifo.read(channel.fifo.getNumReady());
+
+		auto append = [&](int start, int count)
+		{
+			for (int i = 0; i < count; ++i)
+			{
+				channel.history[(size_t)channel.historyWrite] = channel.fifoData[start + i];
+				channel.historyWrite = (channel.historyWrite + 1) & (size - 1);
+			}
+		};
+
+		append(scope.startIndex1, scope.blockSize1);
+		append(scope.startIndex2, scope.blockSize2);
+	}
+
+	for (int i = 0; i < size; ++i)
+		scratch[(size_t)i] = channel.history[(size_t)((channel.historyWrite + i) & (size - 1))];
+
+	window.multiplyWithWindowingTable(scratch.data(), (size_t)size);
+	fft.performFrequencyOnlyForwardTransform(scratch.data(), true);
+
+	// A full-scale sine through a Hann window peaks at a quarter of the FFT size.
+	const auto normalisation = 4.f / (float)size;
+	const auto binWidth = (float)getSampleRate() / (float)size;
+	const auto nyquist = (float)getSampleRate() * 0.5f;
+	const auto logRange = std::log(nyquist / 20.f);
+	const auto numBins = size / 2;
+
+	auto binAt = [&](int point)
+	{
+		return 20.f * std::exp(logRange * (float)point / (float)(numPoints - 1)) / binWidth;
+	};
+
+	juce::Path path;
+
+	for (int point = 0; point < numPoints; ++point)
+	{
+		// Below a bin per point interpolate, above it take the loudest bin the point covers.
+		const auto centre = binAt(point);
+		const auto from = juce::jlimit(0, numBins - 1, (int)std::floor(0.5f * (binAt(point - 1) + centre)));
+		const auto to = juce::jlimit(0, numBins - 1, (int)std::ceil(0.5f * (binAt(point + 1) + centre)));
+
+		float magnitude;
+
+		if (to - from <= 1)
+		{
+			const auto lower = juce::jlimit(0, numBins - 2, (int)centre);
+			const auto fraction = juce::jlimit(0.f, 1.f, centre - (float)lower);
+			magnitude = scratch[(size_t)lower] + (scratch[(size_t)lower + 1] - scratch[(size_t)lower]) * fraction;
+		}
+		else
+		{
+			magnitude = *std::max_element(scratch.begin() + from, scratch.begin() + to + 1);
+		}
+
+		const auto decibels = juce::jmax(minimumDecibels, juce::Decibels::gainToDecibels(magnitude * normalisation, minimumDecibels));
+
+		// Rise quickly, fall slowly.
+		auto& smoothed = channel.smoothed[(size_t)point];
+		smoothed += (decibels - smoothed) * (decibels > smoothed ? 0.6f : 0.15f);
+
+		const auto x = (float)point / (float)(numPoints - 1);
+		const auto y = juce::jmap(smoothed, minimumDecibels, maximumDecibels, 1.f, 0.f);
+
+		if (point == 0)
+			path.startNewSubPath(x, y);
+		else
+			path.lineTo(x, y);
+	}
+
+	const juce::ScopedLock lock(pathLock);
+	channel.path.swapWithPath(path);
+}
@@ -0,0 +1,102 @@
+/*
+  ==============================================================================
+
+	Pre/post spectrum analyser fed from the audio thread through lock-free FIFOs.
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+
+//==============================================================================
+/**
+	Spectrum of the processor's input and output for the editor to draw.
+
+	The audio thread only mixes each block down to mono and pushes it into a
+	wait-free single-producer FIFO, and only while the analyser is running. A
+	background thread pulls from the FIFOs at the frame rate, windows the
+	latest fftSize samples, runs the FFT, smooths the magnitudes and resamples
+	them onto logarithmic frequency points. It leaves the result as a Path in
+	unit coordinates (x: 20 Hz to Nyquist, y: +6 dB at 0 to -90 dB at 1), so
+	the editor only has to scale and stroke it.
+
+	start() and stop() follow the editor's lifetime; while stopped there is no
+	thread and push() returns straight away.
+*/
+class SpectrumAnalyzer
+{
+public:
+	enum class Tap
+	{
+		Pre,
+		Post
+	};
+
+	static constexpr int minimumFFTOrder = 10, maximumFFTOrder = 14;
+	static constexpr int numPoints = 256;
+	static constexpr float minimumDecibels = -90.f, maximumDecibels = 6.f;
+
+	SpectrumAnalyzer();
+	~SpectrumAnalyzer();
+
+	/** Sizes the FIFOs; call from prepareToPlay. */
+	void prepare(double newSampleRate);
+
+	void start();
+	void stop();
+	bool isRunning() const noexcept { return running.load(std::memory_order_relaxed); }
+
+	/** Takes effect from the next frame. */
+	void setFFTOrder(int order) noexcept;
+	int getFFTOrder() const noexcept { return fftOrder.load(); }
+	void setFrameRate(double framesPerSecond) noexcept;
+	double getFrameRate() const noexcept { return frameRate.load(); }
+
+	double getSampleRate() const noexcept { return sampleRate.load(); }
+
+	/** Audio thread: mixes the channels to mono and queues them; wait-free. */
+	template <typename SampleType>
+	void push(Tap tap, const juce::AudioBuffer<SampleType>& buffer) noexcept;
+
+	/** Incremented whenever new paths are ready. */
+	int getFrameCount() const noexcept { return frameCount.load(); }
+
+	/** Copies out the latest path, in unit coordinates. */
+	juce::Path getPath(Tap tap) const;
+
+	/** Where frequency lies on the x axis of the paths, from 0 to 1. */
+	float frequencyToProportion(float frequency) const noexcept;
+
+private:
+	class AnalysisThread;
+
+	struct Channel
+	{
+		juce::AbstractFifo fifo{ 1 << 16 };
+		juce::HeapBlock<float> fifoData;
+
+		// Owned by the analysis thread.
+		std::vector<float> history;
+		int historyWrite = 0;
+		std::vector<float> smoothed;
+		juce::Path path;
+	};
+
+	void analyse(Channel& channel, juce::dsp::FFT& fft, juce::dsp::WindowingFunction<float>& window,
+		std::vector<float>& scratch, int order);
+
+	std::array<Channel, 2> channels;
+	std::unique_ptr<AnalysisThread> thread;
+
+	std::atomic<bool> running{ false };
+	std::atomic<int> fftOrder{ 12 };
+	std::atomic<double> frameRate{ 30.0 };
+	std::atomic<double> sampleRate{ 44100.0 };
+	std::atomic<int> frameCount{ 0 };
+
+	juce::CriticalSection pathLock;
+
+	JUCE_DECLARE_NON_COPYABLE(SpectrumAnalyzer)
+};
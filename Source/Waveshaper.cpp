@@ -0,0 +1,54 @@
+/*
+  ==============================================================================
+
+	Waveshaping curves for the band distortion, evaluated on SIMD registers.
+
+  ==============================================================================
+*/
+
+#include "Waveshaper.h"
+
+juce::String createWaveshaperAccuracyReport()
+{
+	using Shaper = Waveshaper<float>;
+	using Register = Shaper::Register;
+
+	constexpr int numPoints = 1 << 16;
+	constexpr double range = 16.0;
+
+	juce::String report;
+	report << "curve              max abs error    rms error    (float, " << numPoints << " points over +-" << range << ")\n";
+
+	for (int c = 0; c < getWaveshaperCurveNames().size(); ++c)
+	{
+		const auto curve = (WaveshaperCurve)c;
+		Shaper shaper;
+		shaper.setCurve(curve);
+
+		double maxError = 0.0, sumOfSquares = 0.0;
+
+		for (int i = 0; i < numPoints; i += (int)Register::size())
+		{
+			Register x;
+
+			for (size_t lane = 0; lane < Register::size(); ++lane)
+				x.set(lane, (float)(-range + 2.0 * range * (i + (int)lane) / numPoints));
+
+			Register y;
+			shaper.process([&](const auto& fn) { y = fn(x); });
+
+			for (size_t lane = 0; lane < Register::size(); ++lane)
+			{
+				const auto error = std::abs((double)y.get(lane) - WaveshaperReference::evaluate(curve, (double)x.get(lane)));
+				maxError = juce::jmax(maxError, error);
+				sumOfSquares += error * error;
+			}
+		}
+
+		report << getWaveshaperCurveNames()[c].paddedRight(' ', 19)
+			<< juce::String(maxError, 8).paddedRight(' ', 17)
+			<< juce::String(std::sqrt(sumOfSquares / numPoints), 8) << "\n";
+	}
+
+	return report;
+}
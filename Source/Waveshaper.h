@@ -0,0 +1,201 @@
+/*
+  ==============================================================================
+
+	Waveshaping curves for the band distortion, evaluated on SIMD registers.
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+
+enum class WaveshaperCurve
+{
+	SoftClip,
+	HardClip,
+	Tanh,
+	Arctan,
+	AsymmetricTube,
+	Foldback
+};
+
+inline const juce::StringArray& getWaveshaperCurveNames()
+{
+	static const juce::StringArray names{ "Soft Clip", "Hard Clip", "Tanh", "Arctan", "Asymmetric Tube", "Foldback" };
+	return names;
+}
+
+//==============================================================================
+/**
+	Reference (std::) implementations of every curve. These are what the fast
+	versions are built from and checked against; never call them per sample.
+*/
+struct WaveshaperReference
+{
+	static constexpr double tubeBias = 0.3;
+
+	/** Foldback keeps folding out to here; past it, every path holds the input at the limit. */
+	static constexpr double inputRange = 240.0;
+
+	static double evaluate(WaveshaperCurve curve, double x) noexcept
+	{
+		switch (curve)
+		{
+		case WaveshaperCurve::SoftClip:
+			x = juce::jlimit(-1.5, 1.5, x);
+			return x - x * x * x * (4.0 / 27.0);
+		case WaveshaperCurve::HardClip:
+			return juce::jlimit(-1.0, 1.0, x);
+		case WaveshaperCurve::Tanh:
+			return std::tanh(x);
+		case WaveshaperCurve::Arctan:
+			return std::atan(x) * 2.0 / juce::MathConstants<double>::pi;
+		case WaveshaperCurve::AsymmetricTube:
+		{
+			// Biased tanh, rescaled to unity slope at zero: softer on the positive side.
+			const auto t = std::tanh(tubeBias);
+			return (std::tanh(x + tubeBias) - t) / (1.0 - t * t);
+		}
+		case WaveshaperCurve::Foldback:
+		{
+			// Triangle wave through (0, 0) with peaks at +-1: reflects at the rails.
+			const auto phase = (x + 1.0) * 0.25;
+			return 1.0 - std::abs(4.0 * (phase - std::floor(phase)) - 2.0);
+		}
+		}
+
+		return x;
+	}
+};
+
+//==============================================================================
+/**
+	Applies one of the WaveshaperCurves to SIMD registers.
+
+	Soft clip, hard clip and foldback are evaluated exactly with register
+	arithmetic. Tanh, arctan and the tube curve use rational approximations on
+	whole registers, accurate to about 1e-4, so no transcendental function is
+	ever called and no lane is handled on its own.
+
+	process() picks the curve once and hands a concrete functor to the caller's
+	loop, so the per-sample code has no branch on the curve.
+*/
+template <typename FloatType>
+class Waveshaper
+{
+public:
+	using Register = juce::dsp::SIMDRegister<FloatType>;
+
+	void setCurve(WaveshaperCurve newCurve) noexcept { curve = newCurve; }
+	WaveshaperCurve getCurve() const noexcept { return curve; }
+
+	/** Calls fn with a functor Register -> Register for the current curve. */
+	template <typename Function>
+	void process(Function&& fn) const noexcept
+	{
+		switch (curve)
+		{
+		case WaveshaperCurve::SoftClip:       fn(SoftClip{}); break;
+		case WaveshaperCurve::HardClip:       fn(HardClip{}); break;
+		case WaveshaperCurve::Tanh:           fn(Tanh{}); break;
+		case WaveshaperCurve::Arctan:         fn(Arctan{}); break;
+		case WaveshaperCurve::AsymmetricTube: fn(AsymmetricTube{}); break;
+		case WaveshaperCurve::Foldback:       fn(Foldback{}); break;
+		}
+	}
+
+	struct SoftClip
+	{
+		Register operator()(Register x) const noexcept
+		{
+			x = Register::min(Register::expand((FloatType)1.5), Register::max(Register::expand((FloatType)-1.5), x));
+			return x - x * x * x * (FloatType)(4.0 / 27.0);
+		}
+	};
+
+	struct HardClip
+	{
+		Register operator()(Register x) const noexcept
+		{
+			return Register::min(Register::expand((FloatType)1), Register::max(Register::expand((FloatType)-1), x));
+		}
+	};
+
+	struct Foldback
+	{
+		Register operator()(Register x) const noexcept
+		{
+			// Offsetting the phase keeps it positive, so truncation acts as floor.
+			x = Register::min(Register::expand((FloatType)WaveshaperReference::inputRange),
+				Register::max(Register::expand((FloatType)-WaveshaperReference::inputRange), x));
+			const auto phase = x * (FloatType)0.25 + (FloatType)64.25;
+			const auto wrapped = (phase - Register::truncate(phase)) * (FloatType)4 - (FloatType)2;
+			const auto magnitude = Register::max(wrapped, Register::expand((FloatType)0) - wrapped);
+			return Register::expand((FloatType)1) - magnitude;
+		}
+	};
+
+	struct Tanh
+	{
+		Register operator()(Register x) const noexcept
+		{
+			// [7/6] Pade approximant; held at +-4.97, where it meets tanh to within 1e-4 and never passes 1.
+			x = Register::min(Register::expand((FloatType)4.97), Register::max(Register::expand((FloatType)-4.97), x));
+			const auto x2 = x * x;
+			const auto numerator = x * (((x2 + (FloatType)378) * x2 + (FloatType)17325) * x2 + (FloatType)135135);
+			const auto denominator = ((x2 * (FloatType)28 + (FloatType)3150) * x2 + (FloatType)62370) * x2 + (FloatType)135135;
+			return divide(numerator, denominator);
+		}
+	};
+
+	struct Arctan
+	{
+		Register operator()(Register x) const noexcept
+		{
+			// Folds |x| > 1 onto 1/|x| with atan(a) = pi/2 - atan(1/a), so one odd polynomial covers the whole line.
+			const auto one = Register::expand((FloatType)1);
+			const auto magnitude = Register::abs(x);
+			const auto t = divide(Register::min(magnitude, one), Register::max(magnitude, one));
+			const auto t2 = t * t;
+
+			// Minimax fit of atan(t) * 2 / pi on [0, 1].
+			const auto folded = t * (((((t2 * (FloatType)-0.0074619477 + (FloatType)0.0335201446) * t2 + (FloatType)-0.0741234672) * t2
+				+ (FloatType)0.1232135934) * t2 + (FloatType)-0.2117546778) * t2 + (FloatType)0.6366052956);
+
+			const auto unfolded = folded + ((one - folded - folded) & Register::greaterThan(magnitude, one));
+			return unfolded - ((unfolded + unfolded) & Register::lessThan(x, Register::expand((FloatType)0)));
+		}
+	};
+
+	struct AsymmetricTube
+	{
+		Register operator()(Register x) const noexcept
+		{
+			static constexpr auto bias = WaveshaperReference::tubeBias;
+			static constexpr auto t = 0.29131261245159090582; // tanh (tubeBias)
+
+			return (Tanh{}(x + (FloatType)bias) - (FloatType)t) * (FloatType)(1.0 / (1.0 - t * t));
+		}
+	};
+
+private:
+	/** SIMDRegister has no division; a fixed-length loop over aligned lanes compiles to one vector divide. */
+	static Register divide(Register numerator, Register denominator) noexcept
+	{
+		alignas(Register::SIMDRegisterSize) FloatType n[Register::size()];
+		alignas(Register::SIMDRegisterSize) FloatType d[Register::size()];
+		numerator.copyToRawArray(n);
+		denominator.copyToRawArray(d);
+
+		for (size_t lane = 0; lane < Register::size(); ++lane)
+			n[lane] /= d[lane];
+
+		return Register::fromRawArray(n);
+	}
+
+	WaveshaperCurve curve = WaveshaperCurve::SoftClip;
+};
+
+/** Measures every fast curve against WaveshaperReference and returns a readable table of errors. */
+juce::String createWaveshaperAccuracyReport();
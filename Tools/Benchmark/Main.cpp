@@ -0,0 +1,515 @@
+/*
+  ==============================================================================
+
+	processBlock benchmark: runs the processor over a matrix of block sizes,
+	sample rates, channel layouts and parameter scenarios and reports the cost.
+
+	MultibandedDistortionPlugin_Benchmark [options]
+		--block-sizes <list>   comma-separated (default: 1,16,64,256,512,1024,4096)
+		--rates <list>         comma-separated (default: 44100,48000,96000,192000)
+		--channels <list>      comma-separated (default: 1,2)
+		--scenarios <list>     static,automation,preset (default: all)
+		--seconds <value>      audio rendered per case (default: 1)
+		--output <file>        write the results as JSON
+		--baseline <file>      compare against an earlier JSON result
+		--tolerance <percent>  allowed slowdown against the baseline (default: 10)
+		--accuracy             print the waveshaper accuracy reports and exit
+		                       (status 2 if ADAA and the direct curves disagree)
+
+  ==============================================================================
+*/
+
+#include <JuceHeader.h>
+#include "PluginProcessor.h"
+
+#if JUCE_LINUX
+ #include <linux/perf_event.h>
+ #include <sys/ioctl.h>
+ #include <sys/syscall.h>
+ #include <unistd.h>
+#endif
+
+namespace
+{
+	enum class Scenario
+	{
+		Static,
+		Automation,
+		PresetSwitch
+	};
+
+	const juce::StringArray scenarioNames{ "static", "automation", "preset" };
+
+	struct BenchmarkOptions
+	{
+		juce::Array<int> blockSizes{ 1, 16, 64, 256, 512, 1024, 4096 };
+		juce::Array<int> sampleRates{ 44100, 48000, 96000, 192000 };
+		juce::Array<int> channelCounts{ 1, 2 };
+		juce::Array<Scenario> scenarios{ Scenario::Static, Scenario::Automation, Scenario::PresetSwitch };
+		double seconds = 1.0;
+		juce::File output, baseline;
+		double tolerancePercent = 10.0;
+		bool accuracyReport = false;
+	};
+
+	struct BenchmarkResult
+	{
+		int blockSize = 0, sampleRate = 0, numChannels = 0;
+		Scenario scenario = Scenario::Static;
+		double nsPerSample = 0.0;
+		double instructionsPerSample = -1.0;
+		double worstBlockMicroseconds = 0.0;
+		double worstBlockLoad = 0.0;
+
+		juce::String getKey() const
+		{
+			return scenarioNames[(int)scenario] + "/" + juce::String(numChannels) + "ch/"
+				+ juce::String(sampleRate) + "/" + juce::String(blockSize);
+		}
+	};
+
+	//==============================================================================
+	/** Counts user-space instructions retired by the calling thread, where perf is available. */
+	class InstructionCounter
+	{
+	public:
+		InstructionCounter()
+		{
+		   #if JUCE_LINUX
+			perf_event_attr attributes{};
+			attributes.type = PERF_TYPE_HARDWARE;
+			attributes.size = sizeof(attributes);
+			attributes.config = PERF_COUNT_HW_INSTRUCTIONS;
+			attributes.disabled = 1;
+			attributes.exclude_kernel = 1;
+			attributes.exclude_hv = 1;
+			descriptor = (int)syscall(__NR_perf_event_open, &attributes, 0, -1, -1, 0);
+		   #endif
+		}
+
+		~InstructionCounter()
+		{
+		   #if JUCE_LINUX
+			if (descriptor >= 0)
+				close(descriptor);
+		   #endif
+		}
+
+		bool isAvailable() const noexcept { return descriptor >= 0; }
+
+		void reset() noexcept
+		{
+		   #if JUCE_LINUX
+			if (descriptor >= 0)
+				ioctl(descriptor, PERF_EVENT_IOC_RESET, 0);
+		   #endif
+		}
+
+		void resume() noexcept
+		{
+		   #if JUCE_LINUX
+			if (descriptor >= 0)
+				ioctl(descriptor, PERF_EVENT_IOC_ENABLE, 0);
+		   #endif
+		}
+
+		void pause() noexcept
+		{
+		   #if JUCE_LINUX
+			if (descriptor >= 0)
+				ioctl(descriptor, PERF_EVENT_IOC_DISABLE, 0);
+		   #endif
+		}
+
+		/** The count so far, or -1 if it could not be read. */
+		juce::int64 read() const noexcept
+		{
+			long long count = -1;
+
+		   #if JUCE_LINUX
+			if (descriptor >= 0 && ::read(descriptor, &count, sizeof(count)) != (ssize_t)sizeof(count))
+				count = -1;
+		   #endif
+
+			return (juce::int64)count;
+		}
+
+	private:
+		int descriptor = -1;
+
+		JUCE_DECLARE_NON_COPYABLE(InstructionCounter)
+	};
+
+	//==============================================================================
+	void setParameter(MultibandedDistortionPluginAudioProcessor& processor, Param param, float value, int index = 0)
+	{
+		if (auto* parameter = processor.apvts.getParameter(getParameterID(param, index)))
+			parameter->setValueNotifyingHost(parameter->convertTo0to1(value));
+	}
+
+	/** Three driven bands at 2x oversampling: a typical, not a worst, setting. */
+	void applyBaseSettings(MultibandedDistortionPluginAudioProcessor& processor)
+	{
+		setParameter(processor, Param::BandCount, 3.f);
+		setParameter(processor, Param::Oversampling, 1.f);
+		setParameter(processor, Param::PeakGain, 0.f);
+
+		for (int band = 0; band < maxBands; ++band)
+		{
+			setParameter(processor, Param::BandDrive, 12.f, band);
+			setParameter(processor, Param::BandShape, 0.f, band);
+		}
+	}
+
+	/** The setting the preset scenario switches to and from. */
+	void applyAlternateSettings(MultibandedDistortionPluginAudioProcessor& processor)
+	{
+		setParameter(processor, Param::BandCount, 5.f);
+		setParameter(processor, Param::Oversampling, 2.f);
+		setParameter(processor, Param::PeakGain, 6.f);
+
+		for (int band = 0; band < maxBands; ++band)
+		{
+			setParameter(processor, Param::BandDrive, 24.f, band);
+			setParameter(processor, Param::BandShape, (float)(band % getWaveshaperCurveNames().size()), band);
+		}
+	}
+
+	/** Where the preset scenario's settings sit in the bank loadPrograms() builds. */
+	constexpr int alternateProgram = 1, baseProgram = 2;
+
+	/**
+		Gives the processor a program library holding the alternate and base
+		settings, so the preset scenario switches through setCurrentProgram() as
+		a host would. Leaves the parameters at the base settings.
+	*/
+	void loadPrograms(MultibandedDistortionPluginAudioProcessor& processor)
+	{
+		PresetBank bank(processor);
+		applyAlternateSettings(processor);
+		bank.addPreset("Alternate", bank.getCurrentValues());
+		applyBaseSettings(processor);
+		bank.addPreset("Base", bank.getCurrentValues());
+
+		juce::TemporaryFile library(".mbdp");
+
+		{
+			juce::FileOutputStream stream(library.getFile());
+			bank.writeTo(stream);
+		}
+
+		const auto error = processor.loadProgramLibrary(library.getFile());
+		jassertquiet(error.isEmpty());
+	}
+
+	BenchmarkResult runCase(int blockSize, int sampleRate, int numChannels, Scenario scenario, double seconds)
+	{
+		MultibandedDistortionPluginAudioProcessor processor;
+
+		juce::AudioProcessor::BusesLayout layout;
+		layout.inputBuses.add(juce::AudioChannelSet::canonicalChannelSet(numChannels));
+		layout.outputBuses.add(juce::AudioChannelSet::canonicalChannelSet(numChannels));
+		processor.setBusesLayout(layout);
+
+		loadPrograms(processor);
+
+		processor.setRateAndBufferSizeDetails(sampleRate, blockSize);
+		processor.prepareToPlay(sampleRate, blockSize);
+
+		// Noise at -12 dBFS, the same for every run.
+		juce::Random random(0x5eed);
+		juce::AudioBuffer<float> buffer(numChannels, blockSize);
+		juce::MidiBuffer midi;
+
+		auto fill = [&]
+		{
+			for (int channel = 0; channel < numChannels; ++channel)
+				for (int i = 0; i < blockSize; ++i)
+					buffer.setSample(channel, i, (random.nextFloat() * 2.f - 1.f) * 0.25f);
+		};
+
+		const auto numBlocks = juce::jmax(1, (int)(seconds * sampleRate) / blockSize);
+		const auto warmupBlocks = juce::jmax(1, numBlocks / 10);
+		const auto presetInterval = juce::jmax(1, (int)(0.25 * sampleRate) / blockSize);
+		const auto blockSeconds = (double)blockSize / sampleRate;
+
+		for (int block = 0; block < warmupBlocks; ++block)
+		{
+			fill();
+			processor.processBlock(buffer, midi);
+		}
+
+		InstructionCounter instructions;
+		juce::int64 totalTicks = 0, worstTicks = 0;
+
+		instructions.reset();
+
+		for (int block = 0; block < numBlocks; ++block)
+		{
+			fill();
+
+			// Parameter changes land between blocks, outside the timed region, so
+			// what is measured is the DSP reacting to them rather than the host
+			// plumbing that delivers them.
+			if (scenario == Scenario::Automation)
+			{
+				const auto phase = (float)block / (float)numBlocks;
+				setParameter(processor, Param::PeakGain, 12.f * std::sin(juce::MathConstants<float>::twoPi * 4.f * phase));
+				setParameter(processor, Param::BandDrive, 18.f + 12.f * std::sin(juce::MathConstants<float>::twoPi * 3.f * phase), 1);
+			}
+			else if (scenario == Scenario::PresetSwitch && block % presetInterval == 0)
+			{
+				// Only posts the index; the fade and the snapshot switch happen inside the timed processBlock().
+				processor.setCurrentProgram((block / presetInterval) % 2 == 0 ? alternateProgram : baseProgram);
+			}
+
+			instructions.resume();
+			const auto startTicks = juce::Time::getHighResolutionTicks();
+			processor.processBlock(buffer, midi);
+			const auto elapsed = juce::Time::getHighResolutionTicks() - startTicks;
+			instructions.pause();
+
+			totalTicks += elapsed;
+			worstTicks = juce::jmax(worstTicks, elapsed);
+		}
+
+		const auto instructionCount = instructions.read();
+		processor.releaseResources();
+
+		const auto totalSamples = (double)numBlocks * blockSize;
+
+		BenchmarkResult result;
+		result.blockSize = blockSize;
+		result.sampleRate = sampleRate;
+		result.numChannels = numChannels;
+		result.scenario = scenario;
+		result.nsPerSample = juce::Time::highResolutionTicksToSeconds(totalTicks) * 1.0e9 / totalSamples;
+		result.worstBlockMicroseconds = juce::Time::highResolutionTicksToSeconds(worstTicks) * 1.0e6;
+		result.worstBlockLoad = juce::Time::highResolutionTicksToSeconds(worstTicks) / blockSeconds;
+
+		if (instructionCount >= 0)
+			result.instructionsPerSample = (double)instructionCount / totalSamples;
+
+		return result;
+	}
+
+	//==============================================================================
+	juce::var toJSON(const std::vector<BenchmarkResult>& results)
+	{
+		juce::Array<juce::var> entries;
+
+		for (const auto& result : results)
+		{
+			auto* entry = new juce::DynamicObject();
+			entry->setProperty("key", result.getKey());
+			entry->setProperty("scenario", scenarioNames[(int)result.scenario]);
+			entry->setProperty("channels", result.numChannels);
+			entry->setProperty("sampleRate", result.sampleRate);
+			entry->setProperty("blockSize", result.blockSize);
+			entry->setProperty("nsPerSample", result.nsPerSample);
+			entry->setProperty("instructionsPerSample", result.instructionsPerSample >= 0.0 ? juce::var(result.instructionsPerSample) : juce::var());
+			entry->setProperty("worstBlockMicroseconds", result.worstBlockMicroseconds);
+			entry->setProperty("worstBlockLoad", result.worstBlockLoad);
+			entries.add(juce::var(entry));
+		}
+
+		auto* root = new juce::DynamicObject();
+		root->setProperty("version", ProjectInfo::versionString);
+		root->setProperty("cpu", juce::SystemStats::getCpuModel());
+		root->setProperty("results", entries);
+		return juce::var(root);
+	}
+
+	/** Prints cases that got slower than the baseline allows; returns how many did. */
+	int compareWithBaseline(const std::vector<BenchmarkResult>& results, const juce::var& baseline, double tolerancePercent)
+	{
+		std::map<juce::String, double> previous;
+
+		if (auto* entries = baseline["results"].getArray())
+			for (const auto& entry : *entries)
+				previous[entry["key"].toString()] = (double)entry["nsPerSample"];
+
+		int numRegressions = 0;
+
+		for (const auto& result : results)
+		{
+			const auto found = previous.find(result.getKey());
+
+			if (found == previous.end() || found->second <= 0.0)
+				continue;
+
+			const auto change = (result.nsPerSample / found->second - 1.0) * 100.0;
+
+			if (change > tolerancePercent)
+			{
+				std::cout << "REGRESSION " << result.getKey() << ": " << juce::String(found->second, 2) << " -> "
+					<< juce::String(result.nsPerSample, 2) << " ns/sample (+" << juce::String(change, 1) << "%)\n";
+				++numRegressions;
+			}
+		}
+
+		return numRegressions;
+	}
+
+	//==============================================================================
+	template <typename Element, typename Parse>
+	bool parseList(const juce::String& text, juce::Array<Element>& destination, Parse&& parse)
+	{
+		destination.clear();
+
+		for (const auto& token : juce::StringArray::fromTokens(text, ",", ""))
+		{
+			Element element;
+
+			if (!parse(token.trim(), element))
+				return false;
+
+			destination.add(element);
+		}
+
+		return !destination.isEmpty();
+	}
+
+	bool parsePositive(const juce::String& token, int& value)
+	{
+		value = token.getIntValue();
+		return value > 0;
+	}
+
+	bool parseScenario(const juce::String& token, Scenario& scenario)
+	{
+		const auto index = scenarioNames.indexOf(token);
+		scenario = (Scenario)juce::jmax(0, index);
+		return index >= 0;
+	}
+
+	/** Returns an error message, or an empty string if the arguments were usable. */
+	juce::String parseArguments(const juce::StringArray& args, BenchmarkOptions& options)
+	{
+		for (int i = 0; i < args.size(); ++i)
+		{
+			const auto& arg = args[i];
+
+			if (arg == "--accuracy")
+			{
+				options.accuracyReport = true;
+				continue;
+			}
+
+			if (i + 1 >= args.size())
+				return "Missing value for " + arg;
+
+			const auto value = args[++i];
+			auto valid = true;
+
+			if (arg == "--block-sizes")
+				valid = parseList(value, options.blockSizes, parsePositive);
+			else if (arg == "--rates")
+				valid = parseList(value, options.sampleRates, parsePositive);
+			else if (arg == "--channels")
+				valid = parseList(value, options.channelCounts, parsePositive);
+			else if (arg == "--scenarios")
+				valid = parseList(value, options.scenarios, parseScenario);
+			else if (arg == "--seconds")
+				valid = (options.seconds = value.getDoubleValue()) > 0.0;
+			else if (arg == "--output")
+				options.output = juce::File::getCurrentWorkingDirectory().getChildFile(value);
+			else if (arg == "--baseline")
+				options.baseline = juce::File::getCurrentWorkingDirectory().getChildFile(value);
+			else if (arg == "--tolerance")
+				options.tolerancePercent = value.getDoubleValue();
+			else
+				return "Unknown option " + arg;
+
+			if (!valid)
+				return "Invalid value for " + arg + ": " + value;
+		}
+
+		return {};
+	}
+}
+
+//==============================================================================
+int main(int argc, char* argv[])
+{
+	juce::ScopedJuceInitialiser_GUI juceInitialiser;
+
+	juce::StringArray args;
+
+	for (int i = 1; i < argc; ++i)
+		args.add(juce::CharPointer_UTF8(argv[i]));
+
+	BenchmarkOptions options;
+	const auto argumentError = parseArguments(args, options);
+
+	if (argumentError.isNotEmpty())
+	{
+		std::cerr << argumentError << "\n";
+		return 1;
+	}
+
+	if (options.accuracyReport)
+	{
+		bool adaaAgrees = true;
+		std::cout << createWaveshaperAccuracyReport() << "\n" << createAntiderivativeRangeReport(adaaAgrees);
+		return adaaAgrees ? 0 : 2;
+	}
+
+	if (!InstructionCounter().isAvailable())
+		std::cout << "Instruction counts are not available on this system.\n";
+
+	std::cout << juce::String("scenario").paddedRight(' ', 12) << juce::String("ch").paddedRight(' ', 4)
+		<< juce::String("rate").paddedRight(' ', 8) << juce::String("block").paddedRight(' ', 7)
+		<< juce::String("ns/sample").paddedRight(' ', 11) << juce::String("instr/sample").paddedRight(' ', 14)
+		<< juce::String("worst us").paddedRight(' ', 11) << "worst load\n";
+
+	std::vector<BenchmarkResult> results;
+
+	for (auto scenario : options.scenarios)
+		for (auto numChannels : options.channelCounts)
+			for (auto sampleRate : options.sampleRates)
+				for (auto blockSize : options.blockSizes)
+				{
+					const auto result = runCase(blockSize, sampleRate, numChannels, scenario, options.seconds);
+					results.push_back(result);
+
+					std::cout << scenarioNames[(int)scenario].paddedRight(' ', 12) << juce::String(numChannels).paddedRight(' ', 4)
+						<< juce::String(sampleRate).paddedRight(' ', 8) << juce::String(blockSize).paddedRight(' ', 7)
+						<< juce::String(result.nsPerSample, 2).paddedRight(' ', 11)
+						<< (result.instructionsPerSample >= 0.0 ? juce::String(result.instructionsPerSample, 0) : juce::String("-")).paddedRight(' ', 14)
+						<< juce::String(result.worstBlockMicroseconds, 1).paddedRight(' ', 11)
+						<< juce::String(result.worstBlockLoad * 100.0, 1) << "%\n";
+				}
+
+	const auto json = toJSON(results);
+
+	if (options.output != juce::File() && !options.output.replaceWithText(juce::JSON::toString(json)))
+	{
+		std::cerr << "Cannot write " << options.output.getFullPathName() << "\n";
+		return 1;
+	}
+
+	if (options.baseline != juce::File())
+	{
+		const auto baseline = juce::JSON::parse(options.baseline);
+
+		if (baseline.isVoid())
+		{
+			std::cerr << "Cannot read baseline " << options.baseline.getFullPathName() << "\n";
+			return 1;
+		}
+
+		if (compareWithBaseline(results, baseline, options.tolerancePercent) > 0)
+			return 2;
+	}
+
+	if (RealtimeSafety::isEnabled())
+	{
+		std::cout << "\n" << RealtimeSafety::createReport();
+
+		if (RealtimeSafety::getNumViolations() > 0)
+			return 3;
+	}
+
+	return 0;
+}
@@ -0,0 +1,247 @@
+/*
+  ==============================================================================
+
+	Headless offline renderer: streams audio files through the processor in
+	fixed-size blocks, one processor instance per worker.
+
+	MultibandedDistortionPlugin_Render [options] input...
+		--state <file>       parameter state saved by getStateInformation
+		--output <dir>       where rendered files go (default: next to the input)
+		--format <wav|flac>  output format (default: same as the input)
+		--block <samples>    processing block size (default: 512)
+		--jobs <count>       files rendered at once (default: one per core)
+		--trace <dir>        per-file DSP timing traces (MULTIBAND_DSP_TRACE builds)
+
+  ==============================================================================
+*/
+
+#include <JuceHeader.h>
+#include "PluginProcessor.h"
+
+namespace
+{
+	struct RenderOptions
+	{
+		juce::File stateFile;
+		juce::File outputDirectory;
+		juce::File traceDirectory;
+		juce::String format;
+		int blockSize = 512;
+		int numJobs = juce::SystemStats::getNumCpus();
+		juce::Array<juce::File> inputs;
+	};
+
+	void printUsage()
+	{
+		std::cout << "Usage: MultibandedDistortionPlugin_Render [--state file] [--output dir] [--format wav|flac]\n"
+			"                                         [--block samples] [--jobs count] input...\n";
+	}
+
+	/** Returns an error message, or an empty string if the arguments were usable. */
+	juce::String parseArguments(const juce::StringArray& args, RenderOptions& options)
+	{
+		for (int i = 0; i < args.size(); ++i)
+		{
+			const auto& arg = args[i];
+
+			if (!arg.startsWith("--"))
+			{
+				options.inputs.add(juce::File::getCurrentWorkingDirectory().getChildFile(arg));
+				continue;
+			}
+
+			if (i + 1 >= args.size())
+				return "Missing value for " + arg;
+
+			const auto value = args[++i];
+
+			if (arg == "--state")
+				options.stateFile = juce::File::getCurrentWorkingDirectory().getChildFile(value);
+			else if (arg == "--output")
+				options.outputDirectory = juce::File::getCurrentWorkingDirectory().getChildFile(value);
+			else if (arg == "--format")
+				options.format = value.toLowerCase().trimCharactersAtStart(".");
+			else if (arg == "--block")
+				options.blockSize = value.getIntValue();
+			else if (arg == "--jobs")
+				options.numJobs = value.getIntValue();
+			else if (arg == "--trace")
+				options.traceDirectory = juce::File::getCurrentWorkingDirectory().getChildFile(value);
+			else
+				return "Unknown option " + arg;
+		}
+
+		if (options.inputs.isEmpty())
+			return "No input files";
+
+		if (options.blockSize <= 0 || options.numJobs <= 0)
+			return "--block and --jobs must be positive";
+
+		if (options.format.isNotEmpty() && options.format != "wav" && options.format != "flac")
+			return "Unsupported output format " + options.format;
+
+		return {};
+	}
+
+	/** Renders one file; returns an error message, or an empty string on success. */
+	juce::String renderFile(const juce::File& input, const RenderOptions& options, const juce::MemoryBlock& state)
+	{
+		juce::AudioFormatManager formats;
+		formats.registerBasicFormats();
+
+		std::unique_ptr<juce::AudioFormatReader> reader(formats.createReaderFor(input));
+
+		if (reader == nullptr)
+			return "Cannot read " + input.getFullPathName();
+
+		const auto numChannels = (int)reader->numChannels;
+		const auto sampleRate = reader->sampleRate;
+		const auto blockSize = options.blockSize;
+
+		MultibandedDistortionPluginAudioProcessor processor;
+
+		juce::AudioProcessor::BusesLayout layout;
+		layout.inputBuses.add(juce::AudioChannelSet::canonicalChannelSet(numChannels));
+		layout.outputBuses.add(juce::AudioChannelSet::canonicalChannelSet(numChannels));
+
+		if (!processor.setBusesLayout(layout))
+			return input.getFileName() + ": " + juce::String(numChannels) + " channels are not supported";
+
+		if (state.getSize() > 0)
+			processor.setStateInformation(state.getData(), (int)state.getSize());
+
+		if (options.traceDirectory != juce::File())
+			processor.setTraceFile(options.traceDirectory.getChildFile(input.getFileNameWithoutExtension() + "_trace.json"));
+
+		processor.setNonRealtime(true);
+		processor.setRateAndBufferSizeDetails(sampleRate, blockSize);
+		processor.prepareToPlay(sampleRate, blockSize);
+
+		const auto extension = options.format.isNotEmpty() ? options.format : input.getFileExtension().substring(1).toLowerCase();
+		auto* format = formats.findFormatForFileExtension(extension);
+
+		if (format == nullptr)
+			return "No writer for ." + extension;
+
+		const auto directory = options.outputDirectory != juce::File() ? options.outputDirectory : input.getParentDirectory();
+		const auto output = directory.getChildFile(input.getFileNameWithoutExtension() + "_render." + extension);
+		output.deleteFile();
+
+		std::unique_ptr<juce::OutputStream> stream(output.createOutputStream());
+
+		if (stream == nullptr)
+			return "Cannot write " + output.getFullPathName();
+
+		const auto bitDepth = format->getPossibleBitDepths().contains((int)reader->bitsPerSample) ? (int)reader->bitsPerSample : 24;
+		std::unique_ptr<juce::AudioFormatWriter> writer(format->createWriterFor(stream.get(), sampleRate, (unsigned int)numChannels,
+			bitDepth, reader->metadataValues, 0));
+
+		if (writer == nullptr)
+			return "Cannot create a " + extension + " writer for " + output.getFullPathName();
+
+		stream.release();
+
+		// Run the input on by the reported latency and drop that many samples
+		// from the front, so the output lines up with the input.
+		const auto latency = (juce::int64)processor.getLatencySamples();
+		const auto totalLength = reader->lengthInSamples + latency;
+
+		juce::AudioBuffer<float> buffer(numChannels, blockSize);
+		juce::MidiBuffer midi;
+
+		for (juce::int64 position = 0; position < totalLength; position += blockSize)
+		{
+			const auto numSamples = (int)juce::jmin((juce::int64)blockSize, totalLength - position);
+			buffer.setSize(numChannels, numSamples, false, false, true);
+
+			// Reads past the end of the file come back as silence.
+			reader->read(&buffer, 0, numSamples, position, true, true);
+			processor.processBlock(buffer, midi);
+			midi.clear();
+
+			const auto skip = (int)juce::jlimit((juce::int64)0, (juce::int64)numSamples, latency - position);
+
+			if (skip < numSamples && !writer->writeFromAudioSampleBuffer(buffer, skip, numSamples - skip))
+				return "Write failed for " + output.getFullPathName();
+		}
+
+		processor.releaseResources();
+		return {};
+	}
+}
+
+//==============================================================================
+int main(int argc, char* argv[])
+{
+	juce::ScopedJuceInitialiser_GUI juceInitialiser;
+
+	juce::StringArray args;
+
+	for (int i = 1; i < argc; ++i)
+		args.add(juce::CharPointer_UTF8(argv[i]));
+
+	RenderOptions options;
+	const auto argumentError = parseArguments(args, options);
+
+	if (argumentError.isNotEmpty())
+	{
+		std::cerr << argumentError << "\n";
+		printUsage();
+		return 1;
+	}
+
+	juce::MemoryBlock state;
+
+	if (options.stateFile != juce::File() && !options.stateFile.loadFileAsData(state))
+	{
+		std::cerr << "Cannot read state file " << options.stateFile.getFullPathName() << "\n";
+		return 1;
+	}
+
+	for (const auto& directory : { options.outputDirectory, options.traceDirectory })
+	{
+		if (directory != juce::File() && !directory.createDirectory())
+		{
+			std::cerr << "Cannot create " << directory.getFullPathName() << "\n";
+			return 1;
+		}
+	}
+
+	const auto startTime = juce::Time::getMillisecondCounterHiRes();
+
+	std::vector<juce::String> errors((size_t)options.inputs.size());
+
+	{
+		juce::ThreadPool pool(juce::jmin(options.numJobs, options.inputs.size()));
+
+		for (int i = 0; i < options.inputs.size(); ++i)
+			pool.addJob([&, i] { errors[(size_t)i] = renderFile(options.inputs[i], options, state); });
+
+		while (pool.getNumJobs() > 0)
+			juce::Thread::sleep(10);
+	}
+
+	int numFailed = 0;
+
+	for (int i = 0; i < options.inputs.size(); ++i)
+	{
+		if (errors[(size_t)i].isEmpty())
+			continue;
+
+		std::cerr << errors[(size_t)i] << "\n";
+		++numFailed;
+	}
+
+	std::cout << "Rendered " << (options.inputs.size() - numFailed) << " of " << options.inputs.size() << " files in "
+		<< juce::String((juce::Time::getMillisecondCounterHiRes() - startTime) * 0.001, 2) << " s\n";
+
+	if (RealtimeSafety::isEnabled())
+	{
+		std::cout << RealtimeSafety::createReport();
+
+		if (RealtimeSafety::getNumViolations() > 0)
+			return 3;
+	}
+
+	return numFailed == 0 ? 0 : 1;
+}